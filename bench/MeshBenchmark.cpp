@@ -0,0 +1,355 @@
+// Benchmark of the hot paths of the normal harmonization.
+//
+// Synthetic meshes of a given size and defect rate are generated and the time of
+// RebuildNeighbours, MeshEvalOrientation::GetIndices with and without the topology
+// cache of the kernel, VisitNeighbourFacets, MeshTopoAlgorithm::HarmonizeNormals with
+// both orientation strategies, MeshEvalOrientationParity::GetIndices and
+// MeshKernel::RemoveInvalids is measured for several thread counts. Each measurement is the best of some repetitions.
+//
+// Usage: MeshBenchmark [--facets N] [--defects RATE] [--repeat K] [--threads 1,2,4]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "../src/Mod/Mesh/App/Core/Elements.h"
+#include "../src/Mod/Mesh/App/Core/Evaluation.h"
+#include "../src/Mod/Mesh/App/Core/FlagBitmap.h"
+#include "../src/Mod/Mesh/App/Core/MeshKernel.h"
+#include "../src/Mod/Mesh/App/Core/ThreadPool.h"
+#include "../src/Mod/Mesh/App/Core/TopoAlgorithm.h"
+#include "../src/Mod/Mesh/App/Core/Visitor.h"
+
+using namespace MeshCore;
+
+namespace {
+
+struct SyntheticMesh
+{
+    std::string name;
+    MeshPointArray points;
+    MeshFacetArray facets;
+};
+
+void AddPoint (MeshPointArray& points, float x, float y, float z)
+{
+    MeshPoint point;
+    point.Set(x, y, z);
+    points.push_back(point);
+}
+
+/**
+ * Adds the facets of a grid of \a rows x \a columns quads whose corner of row i and
+ * column j is \a corner(i, j). All facets are oriented consistently.
+ */
+void AddGrid (MeshFacetArray& facets, std::size_t rows, std::size_t columns,
+              const std::function<PointIndex(std::size_t, std::size_t)>& corner)
+{
+    for (std::size_t i = 0; i < rows; i++) {
+        for (std::size_t j = 0; j < columns; j++) {
+            PointIndex a = corner(i, j), b = corner(i, j + 1);
+            PointIndex c = corner(i + 1, j), d = corner(i + 1, j + 1);
+            facets.push_back(MeshFacet(a, c, b));
+            facets.push_back(MeshFacet(b, c, d));
+        }
+    }
+}
+
+/** Flips square patches of \a patch x \a patch quads until \a rate of the facets are flipped. */
+void FlipPatches (MeshFacetArray& facets, std::size_t first, std::size_t rows, std::size_t columns,
+                  std::size_t patch, double rate, std::mt19937& rng)
+{
+    patch = std::max<std::size_t>(1, std::min(patch, std::min(rows, columns)));
+    std::size_t goal = static_cast<std::size_t>(rate * 2 * rows * columns);
+    std::uniform_int_distribution<std::size_t> row(0, rows - patch), column(0, columns - patch);
+    std::vector<bool> flipped(2 * rows * columns, false);
+    std::size_t count = 0;
+    while (count < goal) {
+        std::size_t r = row(rng), c = column(rng);
+        for (std::size_t i = r; i < r + patch; i++) {
+            for (std::size_t j = c; j < c + patch; j++) {
+                for (std::size_t k = 0; k < 2; k++) {
+                    std::size_t index = 2 * (i * columns + j) + k;
+                    if (!flipped[index]) {
+                        flipped[index] = true;
+                        facets[first + index].FlipNormal();
+                        count++;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/** A UV sphere with flipped patches. */
+void MakeSphere (SyntheticMesh& mesh, std::size_t ulFacets, double rate, std::mt19937& rng)
+{
+    std::size_t rings = std::max<std::size_t>(3, static_cast<std::size_t>(std::sqrt(ulFacets / 4.0)));
+    std::size_t segments = 2 * rings;
+    const double pi = 3.14159265358979323846;
+
+    AddPoint(mesh.points, 0.0f, 0.0f, 1.0f);
+    for (std::size_t i = 1; i < rings; i++) {
+        double theta = pi * i / rings;
+        for (std::size_t j = 0; j < segments; j++) {
+            double phi = 2.0 * pi * j / segments;
+            AddPoint(mesh.points, static_cast<float>(std::sin(theta) * std::cos(phi)),
+                     static_cast<float>(std::sin(theta) * std::sin(phi)), static_cast<float>(std::cos(theta)));
+        }
+    }
+    AddPoint(mesh.points, 0.0f, 0.0f, -1.0f);
+
+    PointIndex south = static_cast<PointIndex>(mesh.points.size() - 1);
+    auto ring = [segments](std::size_t i, std::size_t j) {
+        return static_cast<PointIndex>(1 + (i - 1) * segments + j % segments);
+    };
+
+    // the body first, so that the patches address a plain grid
+    AddGrid(mesh.facets, rings - 2, segments, [&](std::size_t i, std::size_t j) { return ring(i + 1, j); });
+    FlipPatches(mesh.facets, 0, rings - 2, segments, 8, rate, rng);
+    for (std::size_t j = 0; j < segments; j++) {
+        mesh.facets.push_back(MeshFacet(0, ring(1, j), ring(1, j + 1)));
+        mesh.facets.push_back(MeshFacet(ring(rings - 1, j + 1), ring(rings - 1, j), south));
+    }
+}
+
+/** Many disjoint tetrahedra with randomly flipped facets. */
+void MakeSoup (SyntheticMesh& mesh, std::size_t ulFacets, double rate, std::mt19937& rng)
+{
+    std::bernoulli_distribution flip(rate);
+    std::uniform_real_distribution<float> offset(-100.0f, 100.0f);
+    for (std::size_t t = 0; t < std::max<std::size_t>(1, ulFacets / 4); t++) {
+        PointIndex p = static_cast<PointIndex>(mesh.points.size());
+        float x = offset(rng), y = offset(rng), z = offset(rng);
+        AddPoint(mesh.points, x, y, z);
+        AddPoint(mesh.points, x + 1.0f, y, z);
+        AddPoint(mesh.points, x, y + 1.0f, z);
+        AddPoint(mesh.points, x, y, z + 1.0f);
+        MeshFacet facets[4] = { MeshFacet(p, p + 2, p + 1), MeshFacet(p, p + 1, p + 3),
+                                MeshFacet(p, p + 3, p + 2), MeshFacet(p + 1, p + 2, p + 3) };
+        for (int k = 0; k < 4; k++) {
+            if (flip(rng))
+                facets[k].FlipNormal();
+            mesh.facets.push_back(facets[k]);
+        }
+    }
+}
+
+/** A sphere with \a rate of the facets marked as invalid. */
+void MakeInvalid (SyntheticMesh& mesh, std::size_t ulFacets, double rate, std::mt19937& rng)
+{
+    MakeSphere(mesh, ulFacets, rate, rng);
+    std::bernoulli_distribution invalid(rate);
+    for (MeshFacetArray::_TIterator it = mesh.facets.begin(); it != mesh.facets.end(); ++it) {
+        if (invalid(rng))
+            it->SetFlag(MeshFacet::INVALID);
+    }
+}
+
+/** A strip two facets wide with flipped patches. */
+void MakeStrip (SyntheticMesh& mesh, std::size_t ulFacets, double rate, std::mt19937& rng)
+{
+    std::size_t columns = std::max<std::size_t>(1, ulFacets / 2);
+    for (std::size_t i = 0; i < 2; i++) {
+        for (std::size_t j = 0; j <= columns; j++)
+            AddPoint(mesh.points, static_cast<float>(j), static_cast<float>(i), 0.0f);
+    }
+    AddGrid(mesh.facets, 1, columns, [columns](std::size_t i, std::size_t j) {
+        return static_cast<PointIndex>(i * (columns + 1) + j);
+    });
+    FlipPatches(mesh.facets, 0, 1, columns, 1, rate, rng);
+}
+
+/** Counts the visited facets. */
+class CountVisitor : public MeshFacetVisitor
+{
+public:
+    CountVisitor () : count(0) { }
+    bool Visit (const MeshFacet&, const MeshFacet&, FacetIndex, unsigned long)
+    {
+        count++;
+        return true;
+    }
+    unsigned long count;
+};
+
+/** Returns the best time of \a repeat runs of \a run in seconds, \a prepare is not timed. */
+double Measure (int repeat, const std::function<void()>& prepare, const std::function<void()>& run)
+{
+    double best = 0.0;
+    for (int i = 0; i < repeat; i++) {
+        prepare();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        run();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (i == 0 || seconds < best)
+            best = seconds;
+    }
+    return best;
+}
+
+/** Returns the peak resident set size of the process in MiB. */
+double PeakRss (void)
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+    return usage.ru_maxrss / 1024.0;
+#endif
+}
+
+void Report (const SyntheticMesh& mesh, const char* operation, unsigned int threads, double seconds)
+{
+    double rate = seconds > 0.0 ? mesh.facets.size() / seconds / 1.0e6 : 0.0;
+    std::printf("%-8s %-20s %7u %10.4f %12.2f %10.1f\n", mesh.name.c_str(), operation, threads,
+                seconds, rate, PeakRss());
+    std::fflush(stdout);
+}
+
+void RunCase (const SyntheticMesh& mesh, const std::vector<unsigned int>& threadCounts, int repeat)
+{
+    MeshKernel base;
+    MeshKernel kernel;
+    MeshPointArray points;
+    MeshFacetArray facets;
+
+    for (std::vector<unsigned int>::const_iterator it = threadCounts.begin(); it != threadCounts.end(); ++it) {
+        std::unique_ptr<ThreadPool> pool(*it > 1 ? new ThreadPool(*it) : nullptr);
+
+        double seconds = Measure(repeat, [&]() {
+            points = mesh.points;
+            facets = mesh.facets;
+            kernel.Adopt(points, facets);
+        }, [&]() {
+            kernel.RebuildNeighbours(pool.get());
+        });
+        Report(mesh, "RebuildNeighbours", *it, seconds);
+        base = kernel;
+
+        // a copy starts without cached analyses
+        seconds = Measure(repeat, [&]() { kernel = base; }, [&]() {
+            MeshEvalOrientation eval(kernel);
+            eval.SetThreadPool(pool.get());
+            eval.GetIndices();
+        });
+        Report(mesh, "GetIndices", *it, seconds);
+
+        seconds = Measure(repeat, []() {}, [&]() {
+            MeshEvalOrientation eval(kernel);
+            eval.SetThreadPool(pool.get());
+            eval.GetIndices();
+        });
+        Report(mesh, "GetIndices (cached)", *it, seconds);
+
+        seconds = Measure(repeat, [&]() { kernel = base; }, [&]() {
+            MeshTopoAlgorithm alg(kernel);
+            alg.SetThreadPool(pool.get());
+            alg.HarmonizeNormals();
+        });
+        Report(mesh, "HarmonizeNormals", *it, seconds);
+
+        seconds = Measure(repeat, []() {}, [&]() {
+            MeshEvalOrientationParity eval(base);
+            eval.SetThreadPool(pool.get());
+            std::vector<FacetIndex> indices;
+            eval.GetIndices(indices);
+        });
+        Report(mesh, "GetIndices (parity)", *it, seconds);
+
+        seconds = Measure(repeat, [&]() { kernel = base; }, [&]() {
+            MeshTopoAlgorithm alg(kernel);
+            alg.SetThreadPool(pool.get());
+            alg.HarmonizeNormals(MeshTopoAlgorithm::ParityUnionFind);
+        });
+        Report(mesh, "Harmonize (parity)", *it, seconds);
+
+        seconds = Measure(repeat, [&]() { kernel = base; }, [&]() {
+            kernel.RemoveInvalids(pool.get());
+        });
+        Report(mesh, "RemoveInvalids", *it, seconds);
+    }
+
+    // the traversal itself is serial
+    FlagBitmap visited;
+    double seconds = Measure(repeat, [&]() { visited.Resize(base.CountFacets()); }, [&]() {
+        CountVisitor visitor;
+        std::size_t start = visited.FindFirstReset(0);
+        while (start < visited.Size()) {
+            base.VisitNeighbourFacets(visitor, static_cast<FacetIndex>(start), visited);
+            start = visited.FindFirstReset(start + 1);
+        }
+    });
+    Report(mesh, "VisitNeighbourFacets", 1, seconds);
+}
+
+std::vector<unsigned int> ParseThreads (const std::string& list)
+{
+    std::vector<unsigned int> counts;
+    std::stringstream str(list);
+    std::string item;
+    while (std::getline(str, item, ',')) {
+        unsigned int count = static_cast<unsigned int>(std::strtoul(item.c_str(), nullptr, 10));
+        if (count > 0)
+            counts.push_back(count);
+    }
+    return counts;
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    std::size_t facets = 1000000;
+    double defects = 0.01;
+    int repeat = 3;
+    std::vector<unsigned int> threadCounts;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--facets")
+            facets = std::strtoul(argv[i + 1], nullptr, 10);
+        else if (arg == "--defects")
+            defects = std::min(1.0, std::max(0.0, std::strtod(argv[i + 1], nullptr)));
+        else if (arg == "--repeat")
+            repeat = std::max(1, std::atoi(argv[i + 1]));
+        else if (arg == "--threads")
+            threadCounts = ParseThreads(argv[i + 1]);
+    }
+    if (threadCounts.empty()) {
+        unsigned int hardware = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned int count = 1; count < hardware; count *= 2)
+            threadCounts.push_back(count);
+        threadCounts.push_back(hardware);
+    }
+
+    typedef void (*Generator)(SyntheticMesh&, std::size_t, double, std::mt19937&);
+    const struct { const char* name; Generator make; } cases[] = {
+        { "sphere",  MakeSphere },
+        { "soup",    MakeSoup },
+        { "invalid", MakeInvalid },
+        { "strip",   MakeStrip }
+    };
+
+    std::printf("%-8s %-20s %7s %10s %12s %10s\n", "mesh", "operation", "threads", "seconds",
+                "Mfacets/s", "peak MiB");
+    for (std::size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        std::mt19937 rng(4711);
+        SyntheticMesh mesh;
+        mesh.name = cases[i].name;
+        cases[i].make(mesh, facets, defects, rng);
+        RunCase(mesh, threadCounts, repeat);
+    }
+    return 0;
+}
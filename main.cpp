@@ -1,6 +1,527 @@
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
-int main() {
-    std::cout << "Calling 1 of 5 mesh repair approaches..." << std::endl;
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "src/Mod/Mesh/App/Mesh.h"
+#include "src/Mod/Mesh/App/Core/Batch.h"
+#include "src/Mod/Mesh/App/Core/Elements.h"
+#include "src/Mod/Mesh/App/Core/Evaluation.h"
+#include "src/Mod/Mesh/App/Core/MeshKernel.h"
+#include "src/Mod/Mesh/App/Core/OutOfCore.h"
+#include "src/Mod/Mesh/App/Core/ThreadPool.h"
+#include "src/Mod/Mesh/App/Core/Trace.h"
+
+// Worker protocol
+//
+// A stream carries any number of request frames, each answered by one response
+// frame. All fields are in the byte order of the machine running the worker.
+//
+// Request:  RequestHeader, countPoints * 3 float (x, y, z),
+//           countFacets * 3 uint32_t (corner point indices)
+// Response: ResponseHeader, then on success countFacets * 3 uint32_t with the
+//           harmonized corner indices, on error a message of messageLength bytes
+//
+// After a request with a bad magic number the stream cannot be resynchronized
+// and the worker closes it after the error response. A request that does not fit
+// into memory or whose processing fails is answered with StatusBadMesh and the
+// stream continues.
+namespace {
+
+const uint32_t RequestMagic  = 0x4D525251; // "MRRQ"
+const uint32_t ResponseMagic = 0x4D525250; // "MRRP"
+const uint32_t ProtocolVersion = 1;
+
+enum Status {
+    StatusOk = 0,
+    StatusBadFrame = 1,
+    StatusBadMesh = 2
+};
+
+struct RequestHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t countPoints;
+    uint64_t countFacets;
+};
+
+struct ResponseHeader {
+    uint32_t magic;
+    uint32_t status;
+    uint64_t countFacets;       /**< Number of facets following, 0 on error. */
+    uint64_t countNonManifolds; /**< Number of edges shared by more than two facets. */
+    uint64_t messageLength;     /**< Length of the error message following. */
+};
+
+bool ReadAll (int fd, void* data, std::size_t size)
+{
+    char* pos = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t n = ::read(fd, pos, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        pos += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+/** Reads and discards \a size bytes, e.g. the payload of a request that is rejected. */
+bool SkipAll (int fd, uint64_t size)
+{
+    char buffer[65536];
+    while (size > 0) {
+        std::size_t chunk = static_cast<std::size_t>(std::min<uint64_t>(size, sizeof(buffer)));
+        if (!ReadAll(fd, buffer, chunk))
+            return false;
+        size -= chunk;
+    }
+    return true;
+}
+
+bool WriteAll (int fd, const void* data, std::size_t size)
+{
+    const char* pos = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = ::write(fd, pos, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        pos += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+/**
+ * The RepairWorker class answers the requests of a stream. The thread pool, the
+ * receive buffers, the point and facet arrays and the orientation workspace are
+ * kept between the requests, so that a job only allocates memory if it is larger
+ * than all jobs before.
+ */
+class RepairWorker
+{
+public:
+    explicit RepairWorker (unsigned int threads)
+      : _pool(threads == 1 ? nullptr : new MeshCore::ThreadPool(threads))
+    {
+    }
+
+    /**
+     * Records the phases of all requests and writes them to \a path as Chrome trace
+     * by FlushTrace(). Phases are only recorded if built with MESH_TRACE.
+     */
+    void EnableTrace (const std::string& path)
+    {
+        _trace.reset(new MeshCore::MeshTrace());
+        _tracePath = path;
+    }
+
+    /** Writes the recorded trace and a summary line to stderr, then starts a new trace. */
+    void FlushTrace (void)
+    {
+        if (!_trace)
+            return;
+        std::ofstream file(_tracePath.c_str(), std::ios::out | std::ios::trunc);
+        _trace->WriteChromeTrace(file);
+        std::cerr << "trace: " << _trace->Summary() << std::endl;
+        _trace->Clear();
+    }
+
+    /** Answers all requests of \a in on \a out until end of file. Returns false on a broken stream. */
+    bool Serve (int in, int out)
+    {
+        for (;;) {
+            RequestHeader header;
+            if (!ReadAll(in, &header, sizeof(header)))
+                return true; // end of stream
+            if (header.magic != RequestMagic || header.version != ProtocolVersion) {
+                SendError(out, StatusBadFrame, "unknown frame");
+                return false;
+            }
+            // indices travel as 32-bit values
+            if (header.countPoints > UINT32_MAX || header.countFacets > UINT32_MAX) {
+                SendError(out, StatusBadFrame, "mesh too large");
+                return false;
+            }
+
+            // a header may declare far more than the machine can hold, the payload is
+            // then skipped so that the stream stays in sync
+            try {
+                _coords.resize(header.countPoints * 3);
+                _indices.resize(header.countFacets * 3);
+            }
+            catch (const std::bad_alloc&) {
+                ReleaseBuffers();
+                if (!SkipAll(in, header.countPoints * 3 * sizeof(float) + header.countFacets * 3 * sizeof(uint32_t)) ||
+                    !SendError(out, StatusBadMesh, "mesh too large for available memory"))
+                    return false;
+                continue;
+            }
+            if (!ReadAll(in, _coords.data(), _coords.size() * sizeof(float)) ||
+                !ReadAll(in, _indices.data(), _indices.size() * sizeof(uint32_t)))
+                return false;
+
+            // a failing job must not end the worker for all clients
+            bool sent;
+            try {
+                sent = Process(out);
+            }
+            catch (const std::bad_alloc&) {
+                ReleaseBuffers();
+                sent = SendError(out, StatusBadMesh, "out of memory");
+            }
+            catch (const std::exception& e) {
+                sent = SendError(out, StatusBadMesh, e.what());
+            }
+            catch (...) {
+                sent = SendError(out, StatusBadMesh, "unknown error");
+            }
+            if (!sent)
+                return false;
+        }
+    }
+
+private:
+    bool Process (int out)
+    {
+        const std::size_t countPoints = _coords.size() / 3;
+        const std::size_t countFacets = _indices.size() / 3;
+        for (std::size_t i = 0; i < _indices.size(); i++) {
+            if (_indices[i] >= countPoints)
+                return SendError(out, StatusBadMesh, "point index out of range");
+        }
+
+        _points.resize(countPoints);
+        for (std::size_t i = 0; i < countPoints; i++)
+            _points[i].Set(_coords[3 * i], _coords[3 * i + 1], _coords[3 * i + 2]);
+        _facets.resize(countFacets);
+        for (std::size_t i = 0; i < countFacets; i++) {
+            MeshCore::MeshFacet& facet = _facets[i];
+            for (int j = 0; j < 3; j++)
+                facet._aulPoints[j] = _indices[3 * i + j];
+            facet._ucFlag = 0;
+        }
+
+        // the kernel takes the arrays and hands back those of the previous job
+        _kernel.Adopt(_points, _facets);
+        unsigned long nonManifolds;
+        {
+            MESH_TRACE_SCOPE(_trace.get(), "RebuildNeighbours");
+            nonManifolds = _kernel.RebuildNeighbours(_pool.get());
+        }
+        _mesh.swapKernel(_kernel);
+        _mesh.harmonizeNormals(_pool.get(), _trace.get(), &_workspace);
+        _mesh.swapKernel(_kernel);
+
+        const MeshCore::MeshFacetArray& facets = _kernel.GetFacets();
+        for (std::size_t i = 0; i < countFacets; i++) {
+            for (int j = 0; j < 3; j++)
+                _indices[3 * i + j] = static_cast<uint32_t>(facets[i]._aulPoints[j]);
+        }
+
+        ResponseHeader header;
+        header.magic = ResponseMagic;
+        header.status = StatusOk;
+        header.countFacets = countFacets;
+        header.countNonManifolds = nonManifolds;
+        header.messageLength = 0;
+        return WriteAll(out, &header, sizeof(header)) &&
+               WriteAll(out, _indices.data(), _indices.size() * sizeof(uint32_t));
+    }
+
+    /** Releases the memory kept between the requests, e.g. after running out of memory. */
+    void ReleaseBuffers (void)
+    {
+        std::vector<float>().swap(_coords);
+        std::vector<uint32_t>().swap(_indices);
+        MeshCore::MeshPointArray().swap(_points);
+        MeshCore::MeshFacetArray().swap(_facets);
+        _kernel.Clear();
+        _workspace.Clear();
+    }
+
+    bool SendError (int out, Status status, const std::string& message)
+    {
+        ResponseHeader header;
+        header.magic = ResponseMagic;
+        header.status = status;
+        header.countFacets = 0;
+        header.countNonManifolds = 0;
+        header.messageLength = message.size();
+        return WriteAll(out, &header, sizeof(header)) &&
+               WriteAll(out, message.data(), message.size());
+    }
+
+private:
+    std::unique_ptr<MeshCore::ThreadPool> _pool;
+    std::unique_ptr<MeshCore::MeshTrace> _trace;
+    std::string _tracePath;
+    std::vector<float> _coords;
+    std::vector<uint32_t> _indices;
+    MeshCore::MeshPointArray _points;
+    MeshCore::MeshFacetArray _facets;
+    MeshCore::MeshKernel _kernel;
+    MeshCore::MeshOrientationWorkspace _workspace;
+    Mesh::MeshObject _mesh;
+};
+
+/** Accepts the connections on the UNIX socket \a path one after another. */
+int ServeSocket (RepairWorker& worker, const std::string& path)
+{
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Socket path too long: " << path << std::endl;
+        return 1;
+    }
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    int server = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server < 0) {
+        std::cerr << "Cannot create socket: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    ::unlink(path.c_str());
+    if (::bind(server, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        ::listen(server, 16) < 0) {
+        std::cerr << "Cannot listen on " << path << ": " << std::strerror(errno) << std::endl;
+        ::close(server);
+        return 1;
+    }
+
+    for (;;) {
+        int client = ::accept(server, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR)
+                continue;
+            std::cerr << "Cannot accept connection: " << std::strerror(errno) << std::endl;
+            ::close(server);
+            return 1;
+        }
+        worker.Serve(client, client);
+        ::close(client);
+        worker.FlushTrace();
+    }
+}
+
+/** Harmonizes the normals of the mesh image \a path in place without loading it. */
+int HarmonizeImage (const std::string& path, std::size_t chunk, const std::string& tracePath)
+{
+    std::unique_ptr<MeshCore::MeshTrace> trace;
+    if (!tracePath.empty())
+        trace.reset(new MeshCore::MeshTrace());
+    try {
+        MeshCore::MeshOutOfCoreOrientation orientation(path);
+        if (chunk > 0)
+            orientation.SetChunkSize(chunk);
+        orientation.SetTrace(trace.get());
+        if (!orientation.HarmonizeNormals()) {
+            std::cerr << "Orientation of " << path << " cannot be resolved out of core" << std::endl;
+            return 2;
+        }
+        std::cout << orientation.CountFlipped() << " facets flipped, "
+                  << orientation.CountBoundaryLinks() << " links between chunks" << std::endl;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Cannot harmonize " << path << ": " << e.what() << std::endl;
+        return 1;
+    }
+    if (trace) {
+        std::ofstream file(tracePath.c_str(), std::ios::out | std::ios::trunc);
+        trace->WriteChromeTrace(file);
+        std::cerr << "trace: " << trace->Summary() << std::endl;
+    }
     return 0;
-}
\ No newline at end of file
+}
+
+/**
+ * Writes \a kernel to a temporary file next to \a path and renames it over \a path,
+ * so that the original stays intact if writing fails.
+ */
+bool WriteImage (const MeshCore::MeshKernel& kernel, const std::string& path)
+{
+    std::string tempPath = path + ".XXXXXX";
+    int fd = mkstemp(&tempPath[0]);
+    if (fd < 0)
+        return false;
+    // keep the permissions of the original
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0)
+        fchmod(fd, st.st_mode & 07777);
+    close(fd);
+
+    bool ok = false;
+    try {
+        std::ofstream file(tempPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        kernel.Write(file);
+        file.close();
+        ok = !file.fail() && std::rename(tempPath.c_str(), path.c_str()) == 0;
+    }
+    catch (const std::exception&) {
+    }
+    if (!ok)
+        unlink(tempPath.c_str());
+    return ok;
+}
+
+/**
+ * Removes invalid elements from and harmonizes the normals of the mesh images
+ * \a paths in place, all of them at once on one pool.
+ */
+int BatchImages (const std::vector<std::string>& paths, unsigned int threads, const std::string& tracePath)
+{
+    std::unique_ptr<MeshCore::MeshTrace> trace;
+    if (!tracePath.empty())
+        trace.reset(new MeshCore::MeshTrace());
+
+    int result = 0;
+    std::vector<MeshCore::MeshKernel> kernels(paths.size());
+    std::vector<std::size_t> jobs; // path index of each job
+    std::unique_ptr<MeshCore::ThreadPool> pool(threads == 1 ? nullptr : new MeshCore::ThreadPool(threads));
+    MeshCore::MeshBatch batch(pool.get());
+    batch.SetOperations(MeshCore::MeshBatch::RemoveInvalids | MeshCore::MeshBatch::HarmonizeNormals);
+    batch.SetTrace(trace.get());
+    for (std::size_t i = 0; i < paths.size(); i++) {
+        try {
+            std::ifstream file(paths[i].c_str(), std::ios::in | std::ios::binary);
+            if (!file)
+                throw std::runtime_error(std::strerror(errno));
+            kernels[i].Read(file);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Cannot read " << paths[i] << ": " << e.what() << std::endl;
+            result = 1;
+            continue;
+        }
+        batch.Add(kernels[i]);
+        jobs.push_back(i);
+    }
+
+    batch.Run();
+
+    const std::vector<MeshCore::MeshBatch::Result>& results = batch.GetResults();
+    for (std::size_t j = 0; j < jobs.size(); j++) {
+        const std::string& path = paths[jobs[j]];
+        if (results[j].failed) {
+            std::cerr << "Cannot repair " << path << ": " << results[j].error << std::endl;
+            result = 1;
+            continue;
+        }
+        if (!WriteImage(kernels[jobs[j]], path)) {
+            std::cerr << "Cannot write " << path << std::endl;
+            result = 1;
+            continue;
+        }
+        std::cout << path << ": " << results[j].countFacets << " facets, "
+                  << results[j].seconds * 1000.0 << " ms, latency "
+                  << results[j].latency * 1000.0 << " ms" << std::endl;
+    }
+
+    const MeshCore::MeshBatch::Statistics& stats = batch.GetStatistics();
+    std::cout << stats.countJobs << " meshes (" << stats.countLarge << " large), "
+              << stats.countFacets << " facets in " << stats.seconds << " s: "
+              << stats.jobsPerSecond << " meshes/s, " << stats.facetsPerSecond << " facets/s, latency mean "
+              << stats.meanLatency * 1000.0 << " ms, median " << stats.medianLatency * 1000.0
+              << " ms, max " << stats.maxLatency * 1000.0 << " ms" << std::endl;
+
+    if (trace) {
+        std::ofstream file(tracePath.c_str(), std::ios::out | std::ios::trunc);
+        trace->WriteChromeTrace(file);
+        std::cerr << "trace: " << trace->Summary() << std::endl;
+    }
+    return result;
+}
+
+void PrintUsage (const char* name)
+{
+    std::cerr << "Usage: " << name << " [--serve | --socket PATH | --harmonize FILE | --batch FILE...] [--threads N] [--chunk N] [--trace FILE]" << std::endl
+              << "  --serve        answer repair requests from stdin on stdout" << std::endl
+              << "  --socket PATH  answer repair requests on a UNIX socket" << std::endl
+              << "  --harmonize FILE  harmonize the normals of a mesh image in place, out of core" << std::endl
+              << "  --batch FILE   repair the mesh image FILE in place, may be repeated to repair many at once" << std::endl
+              << "  --threads N    number of worker threads, 0 for one per core (default)" << std::endl
+              << "  --chunk N      number of facets loaded at once by --harmonize" << std::endl
+              << "  --trace FILE   write a Chrome trace of each stream to FILE and a summary to stderr" << std::endl;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    bool serve = false;
+    std::string socketPath;
+    unsigned int threads = 0;
+    std::string tracePath;
+    std::string imagePath;
+    std::vector<std::string> batchPaths;
+    std::size_t chunk = 0;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--serve") {
+            serve = true;
+        }
+        else if (arg == "--socket" && i + 1 < argc) {
+            socketPath = argv[++i];
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            threads = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--harmonize" && i + 1 < argc) {
+            imagePath = argv[++i];
+        }
+        else if (arg == "--batch" && i + 1 < argc) {
+            batchPaths.push_back(argv[++i]);
+        }
+        else if (arg == "--chunk" && i + 1 < argc) {
+            chunk = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--trace" && i + 1 < argc) {
+            tracePath = argv[++i];
+        }
+        else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!imagePath.empty())
+        return HarmonizeImage(imagePath, chunk, tracePath);
+    if (!batchPaths.empty())
+        return BatchImages(batchPaths, threads, tracePath);
+
+    if (!serve && socketPath.empty()) {
+        std::cout << "Calling 1 of 5 mesh repair approaches..." << std::endl;
+        return 0;
+    }
+
+    // a client going away must not kill the worker
+    std::signal(SIGPIPE, SIG_IGN);
+
+    RepairWorker worker(threads);
+    if (!tracePath.empty())
+        worker.EnableTrace(tracePath);
+    if (!socketPath.empty())
+        return ServeSocket(worker, socketPath);
+    bool ok = worker.Serve(STDIN_FILENO, STDOUT_FILENO);
+    worker.FlushTrace();
+    return ok ? 0 : 1;
+}
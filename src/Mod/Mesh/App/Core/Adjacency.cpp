@@ -0,0 +1,168 @@
+/***************************************************************************
+ *   Copyright (c) 2026 The mesh-repair contributors                       *
+ *                                                                         *
+ *   This file is part of mesh-repair, which is based on FreeCAD.          *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# include <algorithm>
+# include <cstdint>
+#endif
+
+#include "Adjacency.h"
+#include "ThreadPool.h"
+
+using namespace MeshCore;
+
+namespace {
+
+/** All keys of an edge go to the same shard. */
+inline std::size_t EdgeShard (PointIndex ulP0, std::size_t ulMask)
+{
+    return static_cast<std::size_t>((static_cast<uint64_t>(ulP0) * 0x9E3779B97F4A7C15ULL) >> 40) & ulMask;
+}
+
+}
+
+MeshAdjacencyBuilder::MeshAdjacencyBuilder (MeshFacetArray& rclFacets)
+  : _rclFacets(rclFacets), _pool(nullptr)
+{
+}
+
+MeshAdjacencyBuilder::~MeshAdjacencyBuilder (void)
+{
+}
+
+unsigned long MeshAdjacencyBuilder::Build (void)
+{
+    _aclNonManifolds.clear();
+
+    const std::size_t ulCtFacets = _rclFacets.size();
+    if (ulCtFacets == 0)
+        return 0;
+
+    // a few shards per thread to balance the sorting, and shards small
+    // enough to be sorted in the cache
+    std::size_t ulMinShards = 3 * ulCtFacets / 65536;
+    if (_pool)
+        ulMinShards = std::max<std::size_t>(ulMinShards, 4 * _pool->CountThreads());
+    std::size_t ulShards = 1;
+    while (ulShards < ulMinShards)
+        ulShards *= 2;
+    const std::size_t ulMask = ulShards - 1;
+
+    const std::size_t ulGrain = GrainSize(_pool, ulCtFacets, 4096);
+    const std::size_t ulChunks = (ulCtFacets + ulGrain - 1) / ulGrain;
+
+    // count the edges of each chunk per shard
+    std::vector<std::size_t> aulOffsets(ulChunks * ulShards, 0);
+    MeshFacetArray& rFacets = _rclFacets;
+    ParallelFor(_pool, 0, ulChunks, 1, [&](std::size_t b, std::size_t e) {
+        for (std::size_t c = b; c < e; c++) {
+            std::size_t* pCount = &aulOffsets[c * ulShards];
+            std::size_t ulEnd = std::min(ulCtFacets, (c + 1) * ulGrain);
+            for (std::size_t i = c * ulGrain; i < ulEnd; i++) {
+                const PointIndex* pPoints = rFacets[i]._aulPoints;
+                for (int j = 0; j < 3; j++)
+                    pCount[EdgeShard(std::min(pPoints[j], pPoints[(j + 1) % 3]), ulMask)]++;
+            }
+        }
+    });
+
+    // turn the counts into write positions, shard by shard, chunk by chunk
+    std::vector<std::size_t> aulShardBegin(ulShards + 1, 0);
+    std::size_t ulPos = 0;
+    for (std::size_t s = 0; s < ulShards; s++) {
+        aulShardBegin[s] = ulPos;
+        for (std::size_t c = 0; c < ulChunks; c++) {
+            std::size_t ulCount = aulOffsets[c * ulShards + s];
+            aulOffsets[c * ulShards + s] = ulPos;
+            ulPos += ulCount;
+        }
+    }
+    aulShardBegin[ulShards] = ulPos;
+
+    // write the keys directly to their shard and reset the neighbourhood
+    std::vector<EdgeKey> aclKeys(ulPos);
+    ParallelFor(_pool, 0, ulChunks, 1, [&](std::size_t b, std::size_t e) {
+        for (std::size_t c = b; c < e; c++) {
+            std::size_t* pPos = &aulOffsets[c * ulShards];
+            std::size_t ulEnd = std::min(ulCtFacets, (c + 1) * ulGrain);
+            for (std::size_t i = c * ulGrain; i < ulEnd; i++) {
+                MeshFacet& rFacet = rFacets[i];
+                for (int j = 0; j < 3; j++) {
+                    PointIndex ulP0 = rFacet._aulPoints[j];
+                    PointIndex ulP1 = rFacet._aulPoints[(j + 1) % 3];
+                    EdgeKey& rKey = aclKeys[pPos[EdgeShard(std::min(ulP0, ulP1), ulMask)]++];
+                    rKey.ulP0 = std::min(ulP0, ulP1);
+                    rKey.ulP1 = std::max(ulP0, ulP1);
+                    rKey.ulSide = static_cast<uint64_t>(i) * 3 + j;
+                    rFacet._aulNeighbours[j] = FACET_INDEX_MAX;
+                }
+            }
+        }
+    });
+
+    // sort and match each shard, every facet side is written by exactly one shard
+    std::vector<std::vector<Edge> > aclShardNonManifolds(ulShards);
+    ParallelFor(_pool, 0, ulShards, 1, [&](std::size_t b, std::size_t e) {
+        for (std::size_t s = b; s < e; s++) {
+            EdgeKey* pBegin = aclKeys.data() + aulShardBegin[s];
+            EdgeKey* pEnd = aclKeys.data() + aulShardBegin[s + 1];
+            std::sort(pBegin, pEnd);
+            MatchShard(pBegin, pEnd, aclShardNonManifolds[s]);
+        }
+    });
+
+    for (std::size_t s = 0; s < ulShards; s++)
+        _aclNonManifolds.insert(_aclNonManifolds.end(), aclShardNonManifolds[s].begin(),
+                                aclShardNonManifolds[s].end());
+    std::sort(_aclNonManifolds.begin(), _aclNonManifolds.end());
+
+    return static_cast<unsigned long>(_aclNonManifolds.size());
+}
+
+void MeshAdjacencyBuilder::MatchShard (const EdgeKey* pBegin, const EdgeKey* pEnd,
+                                       std::vector<Edge>& rclNonManifolds)
+{
+    const EdgeKey* pRun = pBegin;
+    while (pRun != pEnd) {
+        const EdgeKey* pNext = pRun + 1;
+        while (pNext != pEnd && pNext->ulP0 == pRun->ulP0 && pNext->ulP1 == pRun->ulP1)
+            ++pNext;
+
+        if (pNext - pRun == 2) {
+            FacetIndex ulFacet0 = static_cast<FacetIndex>(pRun[0].ulSide / 3);
+            FacetIndex ulFacet1 = static_cast<FacetIndex>(pRun[1].ulSide / 3);
+            // a degenerated facet may use the edge twice, keep it open then
+            if (ulFacet0 != ulFacet1) {
+                _rclFacets[ulFacet0]._aulNeighbours[pRun[0].ulSide % 3] = ulFacet1;
+                _rclFacets[ulFacet1]._aulNeighbours[pRun[1].ulSide % 3] = ulFacet0;
+            }
+        }
+        else if (pNext - pRun > 2) {
+            rclNonManifolds.push_back(Edge(pRun->ulP0, pRun->ulP1));
+        }
+
+        pRun = pNext;
+    }
+}
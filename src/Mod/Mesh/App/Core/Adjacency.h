@@ -0,0 +1,93 @@
+/***************************************************************************
+ *   Copyright (c) 2026 The mesh-repair contributors                       *
+ *                                                                         *
+ *   This file is part of mesh-repair, which is based on FreeCAD.          *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef MESH_ADJACENCY_H
+#define MESH_ADJACENCY_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "Elements.h"
+
+namespace MeshCore {
+
+class ThreadPool;
+
+/**
+ * The MeshAdjacencyBuilder class fills in the neighbour indices of a facet array
+ * from the corner point indices alone, e.g. for a triangle soup read from a file.
+ *
+ * All edges are collected as sorted (point, point) keys together with their facet
+ * and side. The keys are distributed over shards by the hash of the smaller point
+ * index, each shard is sorted on its own and equal keys are matched. An edge shared
+ * by exactly two different facets links them, an edge of one facet is open and an
+ * edge shared by more than two facets is non-manifold and left open for all of them.
+ * With a ThreadPool the collection, sorting and matching run in parallel. The result
+ * does not depend on the number of threads.
+ */
+class MeshExport MeshAdjacencyBuilder
+{
+public:
+    typedef std::pair<PointIndex, PointIndex> Edge;
+
+    MeshAdjacencyBuilder (MeshFacetArray& rclFacets);
+    ~MeshAdjacencyBuilder (void);
+
+    /** Uses \a pool to build the neighbourhood. If \a pool is null the builder runs serially. */
+    void SetThreadPool (ThreadPool* pool)
+    { _pool = pool; }
+    /**
+     * Overwrites the neighbour indices of all facets. Returns the number of
+     * non-manifold edges.
+     */
+    unsigned long Build (void);
+    /**
+     * Returns the non-manifold edges found by the last call of Build(), the smaller
+     * point index first, in ascending order.
+     */
+    const std::vector<Edge>& GetNonManifolds (void) const
+    { return _aclNonManifolds; }
+
+private:
+    struct EdgeKey {
+        PointIndex   ulP0, ulP1;
+        uint64_t     ulSide; /**< facet index * 3 + side, 64-bit so that it cannot overflow with 32-bit indices */
+        bool operator < (const EdgeKey& rclKey) const
+        {
+            if (ulP0 != rclKey.ulP0) return ulP0 < rclKey.ulP0;
+            if (ulP1 != rclKey.ulP1) return ulP1 < rclKey.ulP1;
+            return ulSide < rclKey.ulSide;
+        }
+    };
+
+    void MatchShard (const EdgeKey* pBegin, const EdgeKey* pEnd, std::vector<Edge>& rclNonManifolds);
+
+    MeshFacetArray& _rclFacets;
+    ThreadPool* _pool;
+    std::vector<Edge> _aclNonManifolds;
+};
+
+} // namespace MeshCore
+
+#endif // MESH_ADJACENCY_H
@@ -40,19 +40,21 @@
 using namespace MeshCore;
 
 
-void MeshAlgorithm::SetFacetsFlag (const std::vector<unsigned long> &raulInds, MeshFacet::TFlagType tF) const
+void MeshAlgorithm::SetFacetsFlag (const std::vector<FacetIndex> &raulInds, MeshFacet::TFlagType tF) const
 {
-    for (std::vector<unsigned long>::const_iterator i = raulInds.begin(); i != raulInds.end(); ++i)
-        _rclMesh._aclFacetArray[*i].SetFlag(tF);
+    MeshFacetArray& rFacets = _rclMesh._clFacets.Detach();
+    for (std::vector<FacetIndex>::const_iterator i = raulInds.begin(); i != raulInds.end(); ++i)
+        rFacets[*i].SetFlag(tF);
 }
 
-void MeshAlgorithm::ResetFacetsFlag (const std::vector<unsigned long> &raulInds, MeshFacet::TFlagType tF) const
+void MeshAlgorithm::ResetFacetsFlag (const std::vector<FacetIndex> &raulInds, MeshFacet::TFlagType tF) const
 {
-    for (std::vector<unsigned long>::const_iterator i = raulInds.begin(); i != raulInds.end(); ++i)
-        _rclMesh._aclFacetArray[*i].ResetFlag(tF);
+    MeshFacetArray& rFacets = _rclMesh._clFacets.Detach();
+    for (std::vector<FacetIndex>::const_iterator i = raulInds.begin(); i != raulInds.end(); ++i)
+        rFacets[*i].ResetFlag(tF);
 }
 
 void MeshAlgorithm::ResetFacetFlag (MeshFacet::TFlagType tF) const
 {
-    _rclMesh._aclFacetArray.ResetFlag(tF);
+    _rclMesh._clFacets.Detach().ResetFlag(tF);
 }
@@ -49,10 +49,10 @@ public:
 public:
     /** Resets of all facets the flag \a tF. */
     void ResetFacetFlag (MeshFacet::TFlagType tF) const;
+    /** Sets for all facets in \a raulInds the flag \a tF. */
+    void SetFacetsFlag (const std::vector<FacetIndex> &raulInds, MeshFacet::TFlagType tF) const;
     /** Resets from all facets in \a raulInds the flag \a tF. */
-    void ResetFacetsFlag (const std::vector<unsigned long> &raulInds, MeshFacet::TFlagType tF) const;
-    /** Resets from all facets in \a raulInds the flag \a tF. */
-    void ResetFacetsFlag (const std::vector<unsigned long> &raulInds, MeshFacet::TFlagType tF) const;
+    void ResetFacetsFlag (const std::vector<FacetIndex> &raulInds, MeshFacet::TFlagType tF) const;
   
 protected:
   const MeshKernel      &_rclMesh; /**< The mesh kernel. */
@@ -0,0 +1,188 @@
+/***************************************************************************
+ *   Copyright (c) 2026 The mesh-repair contributors                       *
+ *                                                                         *
+ *   This file is part of mesh-repair, which is based on FreeCAD.          *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# include <algorithm>
+# include <chrono>
+# include <exception>
+#endif
+
+#include "Batch.h"
+#include "Evaluation.h"
+#include "MeshKernel.h"
+#include "ThreadPool.h"
+#include "Trace.h"
+
+using namespace MeshCore;
+
+namespace {
+
+double Now (void)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}
+
+MeshBatch::MeshBatch (ThreadPool* pool)
+  : _pool(pool), _trace(nullptr), _iOperations(HarmonizeNormals),
+    _tStrategy(MeshTopoAlgorithm::RegionGrowing), _ulLargeThreshold(65536), _fStart(0.0)
+{
+    Summarize(0.0);
+}
+
+MeshBatch::~MeshBatch (void)
+{
+}
+
+std::size_t MeshBatch::Add (MeshKernel& rclMesh)
+{
+    _aclJobs.push_back(&rclMesh);
+    return _aclJobs.size() - 1;
+}
+
+void MeshBatch::Clear (void)
+{
+    _aclJobs.clear();
+    _aclResults.clear();
+    Summarize(0.0);
+}
+
+void MeshBatch::Run (void)
+{
+    MESH_TRACE_SCOPE(_trace, "Batch");
+    const std::size_t ulCount = _aclJobs.size();
+    Result clEmpty;
+    clEmpty.countFacets = 0;
+    clEmpty.seconds = 0.0;
+    clEmpty.latency = 0.0;
+    clEmpty.failed = false;
+    _aclResults.assign(ulCount, clEmpty);
+    for (std::size_t i = 0; i < ulCount; i++)
+        _aclResults[i].countFacets = _aclJobs[i]->CountFacets();
+
+    // largest first
+    std::vector<std::size_t> aulOrder(ulCount);
+    for (std::size_t i = 0; i < ulCount; i++)
+        aulOrder[i] = i;
+    std::stable_sort(aulOrder.begin(), aulOrder.end(), [this](std::size_t a, std::size_t b) {
+        return _aclResults[a].countFacets > _aclResults[b].countFacets;
+    });
+
+    _fStart = Now();
+    TaskGroup group(_pool);
+    std::size_t i = 0;
+    for (; i < ulCount && _aclResults[aulOrder[i]].countFacets >= _ulLargeThreshold; i++) {
+        const std::size_t ulJob = aulOrder[i];
+        group.Run([this, ulJob]() {
+            MeshOrientationWorkspace clWorkspace;
+            Process(ulJob, _pool, clWorkspace);
+        });
+    }
+    while (i < ulCount) {
+        // small meshes in tasks of about the threshold, sharing one workspace
+        const std::size_t b = i;
+        std::size_t ulFacets = 0;
+        do {
+            ulFacets += _aclResults[aulOrder[i]].countFacets;
+            i++;
+        } while (i < ulCount && ulFacets < _ulLargeThreshold);
+        const std::size_t e = i;
+        group.Run([this, b, e, &aulOrder]() {
+            MeshOrientationWorkspace clWorkspace;
+            for (std::size_t k = b; k < e; k++)
+                Process(aulOrder[k], nullptr, clWorkspace);
+        });
+    }
+    group.Wait();
+
+    Summarize(Now() - _fStart);
+}
+
+void MeshBatch::Process (std::size_t ulJob, ThreadPool* pool, MeshOrientationWorkspace& rclWorkspace)
+{
+    MESH_TRACE_SCOPE(_trace, "BatchJob");
+    Result& rclResult = _aclResults[ulJob];
+    MeshKernel& rclMesh = *_aclJobs[ulJob];
+    const double fBegin = Now();
+    try {
+        if (_iOperations & RemoveInvalids)
+            rclMesh.RemoveInvalids(pool);
+        if (_iOperations & HarmonizeNormals) {
+            MeshTopoAlgorithm clAlg(rclMesh);
+            clAlg.SetThreadPool(pool);
+            clAlg.SetTrace(_trace);
+            clAlg.SetWorkspace(&rclWorkspace);
+            clAlg.HarmonizeNormals(_tStrategy);
+        }
+    }
+    catch (const std::exception& e) {
+        rclResult.failed = true;
+        rclResult.error = e.what();
+    }
+    catch (...) {
+        rclResult.failed = true;
+        rclResult.error = "unknown error";
+    }
+    const double fEnd = Now();
+    rclResult.seconds = fEnd - fBegin;
+    rclResult.latency = fEnd - _fStart;
+}
+
+void MeshBatch::Summarize (double fSeconds)
+{
+    Statistics& s = _clStatistics;
+    s.countJobs = _aclResults.size();
+    s.countLarge = 0;
+    s.countFailed = 0;
+    s.countFacets = 0;
+    s.seconds = fSeconds;
+    s.meanLatency = 0.0;
+    s.medianLatency = 0.0;
+    s.maxLatency = 0.0;
+
+    std::vector<double> afLatencies;
+    afLatencies.reserve(_aclResults.size());
+    for (std::size_t i = 0; i < _aclResults.size(); i++) {
+        const Result& r = _aclResults[i];
+        s.countFacets += r.countFacets;
+        if (r.countFacets >= _ulLargeThreshold)
+            s.countLarge++;
+        if (r.failed)
+            s.countFailed++;
+        s.meanLatency += r.latency;
+        s.maxLatency = std::max(s.maxLatency, r.latency);
+        afLatencies.push_back(r.latency);
+    }
+
+    if (!afLatencies.empty()) {
+        s.meanLatency /= static_cast<double>(afLatencies.size());
+        std::vector<double>::iterator mid = afLatencies.begin() + afLatencies.size() / 2;
+        std::nth_element(afLatencies.begin(), mid, afLatencies.end());
+        s.medianLatency = *mid;
+    }
+    s.jobsPerSecond = fSeconds > 0.0 ? static_cast<double>(s.countJobs) / fSeconds : 0.0;
+    s.facetsPerSecond = fSeconds > 0.0 ? static_cast<double>(s.countFacets) / fSeconds : 0.0;
+}
@@ -0,0 +1,143 @@
+/***************************************************************************
+ *   Copyright (c) 2026 The mesh-repair contributors                       *
+ *                                                                         *
+ *   This file is part of mesh-repair, which is based on FreeCAD.          *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef MESH_BATCH_H
+#define MESH_BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Definitions.h"
+#include "TopoAlgorithm.h"
+
+namespace MeshCore {
+
+class MeshKernel;
+class MeshOrientationWorkspace;
+class MeshTrace;
+class ThreadPool;
+
+/**
+ * The MeshBatch class processes many meshes on one thread pool, e.g. a few huge
+ * meshes mixed with thousands of tiny ones. Small meshes are processed serially,
+ * many of them concurrently, and a large mesh runs its own parallel phases on the
+ * pool. As both levels share the work-stealing pool, a thread waiting for the
+ * phases of a large mesh helps with the small meshes and the machine is never
+ * oversubscribed.
+ * The jobs are started in descending order of their size so that the large
+ * meshes do not end up as stragglers. A job that throws is marked as failed, the
+ * other jobs are not affected.
+ */
+class MeshExport MeshBatch
+{
+public:
+    /** The operations applied to each mesh, in this order. */
+    enum Operation {
+        RemoveInvalids   = 1, /**< MeshKernel::RemoveInvalids() */
+        HarmonizeNormals = 2  /**< MeshTopoAlgorithm::HarmonizeNormals() */
+    };
+
+    /** Outcome of one job. */
+    struct Result
+    {
+        unsigned long countFacets; /**< Facets of the mesh before processing. */
+        double seconds; /**< Processing time of the job. */
+        double latency; /**< Time from the start of Run() until the job has finished. */
+        bool failed;
+        std::string error;
+    };
+
+    /** Summary of the last Run(). */
+    struct Statistics
+    {
+        std::size_t countJobs;
+        std::size_t countLarge;  /**< Jobs processed in parallel on their own. */
+        std::size_t countFailed;
+        uint64_t countFacets;    /**< Facets of all jobs before processing. */
+        double seconds;          /**< Wall time of Run(). */
+        double jobsPerSecond;
+        double facetsPerSecond;
+        double meanLatency;
+        double medianLatency;
+        double maxLatency;
+    };
+
+    /** Runs the jobs on \a pool, or one after another on the calling thread if it is null. */
+    explicit MeshBatch (ThreadPool* pool);
+    ~MeshBatch (void);
+
+    /** Sets the operations as combination of Operation, HarmonizeNormals by default. */
+    void SetOperations (int iOperations)
+    { _iOperations = iOperations; }
+    /** Sets the orientation strategy of HarmonizeNormals. */
+    void SetStrategy (MeshTopoAlgorithm::OrientationStrategy tStrategy)
+    { _tStrategy = tStrategy; }
+    /**
+     * Meshes with at least \a ulFacets facets use the pool for their own phases,
+     * smaller meshes are grouped into tasks of about this many facets.
+     */
+    void SetLargeThreshold (std::size_t ulFacets)
+    { _ulLargeThreshold = ulFacets; }
+    /** Records the phases and counters in \a trace if built with MESH_TRACE. */
+    void SetTrace (MeshTrace* trace)
+    { _trace = trace; }
+
+    /**
+     * Adds \a rclMesh as job and returns its index. The mesh is modified in place and
+     * must live until Run() has returned.
+     */
+    std::size_t Add (MeshKernel& rclMesh);
+    /** Removes all jobs and results. */
+    void Clear (void);
+    /** Processes all jobs and waits for them. */
+    void Run (void);
+
+    /** Returns the outcome of each job in the order the jobs were added. */
+    const std::vector<Result>& GetResults (void) const
+    { return _aclResults; }
+    const Statistics& GetStatistics (void) const
+    { return _clStatistics; }
+
+private:
+    void Process (std::size_t ulJob, ThreadPool* pool, MeshOrientationWorkspace& rclWorkspace);
+    void Summarize (double fSeconds);
+
+    MeshBatch (const MeshBatch&);
+    void operator = (const MeshBatch&);
+
+    ThreadPool* _pool;
+    MeshTrace* _trace;
+    int _iOperations;
+    MeshTopoAlgorithm::OrientationStrategy _tStrategy;
+    std::size_t _ulLargeThreshold;
+    std::vector<MeshKernel*> _aclJobs;
+    std::vector<Result> _aclResults;
+    Statistics _clStatistics;
+    double _fStart; /**< Start of Run() in seconds of the steady clock. */
+};
+
+} // namespace MeshCore
+
+#endif // MESH_BATCH_H
@@ -43,11 +43,23 @@ MeshPointArray::MeshPointArray(const MeshPointArray& ary)
 {
 }
 
+MeshPointArray& MeshPointArray::operator = (const MeshPointArray& ary)
+{
+  TMeshPointArray::operator = (ary);
+  return *this;
+}
+
 MeshFacetArray::MeshFacetArray(const MeshFacetArray& ary)
   : TMeshFacetArray(ary)
 {
 }
 
+MeshFacetArray& MeshFacetArray::operator = (const MeshFacetArray& ary)
+{
+  TMeshFacetArray::operator = (ary);
+  return *this;
+}
+
 void MeshFacetArray::ResetFlag (MeshFacet::TFlagType tF) const
 {
   for (MeshFacetArray::_TConstIterator i = begin(); i < end(); ++i) i->ResetFlag(tF);
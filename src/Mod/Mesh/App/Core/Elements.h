@@ -28,8 +28,12 @@
 #include <vector>
 #include <climits>
 #include <cstring>
+#include <cstdint>
+#include <limits>
+#include <utility>
 
 #include "Definitions.h"
+#include "Storage.h"
 
 #include <Base/BoundBox.h>
 #include <Base/Vector3D.h>
@@ -41,6 +45,26 @@
 
 namespace MeshCore {
 
+/** @name Index types
+ * By default points and facets are addressed with 'unsigned long'. If the library
+ * is built with MESH_COMPACT_INDICES all indices are 32-bit which halves the size
+ * of a MeshFacet on 64-bit Linux and is sufficient for meshes with less than
+ * 4 billion points and facets.
+ */
+//@{
+#ifdef MESH_COMPACT_INDICES
+typedef uint32_t ElementIndex;
+#else
+typedef unsigned long ElementIndex;
+#endif
+typedef ElementIndex FacetIndex;
+typedef ElementIndex PointIndex;
+/// Marks an invalid index, e.g. an open edge of a facet
+const ElementIndex ELEMENT_INDEX_MAX = std::numeric_limits<ElementIndex>::max();
+const FacetIndex FACET_INDEX_MAX = ELEMENT_INDEX_MAX;
+const PointIndex POINT_INDEX_MAX = ELEMENT_INDEX_MAX;
+//@}
+
 /**
  * The MeshFacet class represent a triangle facet in the mesh data.structure. A facet indexes
  * three neighbour facets and also three corner points.
@@ -50,7 +74,7 @@ namespace MeshCore {
  * \li neighbour or edge number of 0 is defined by corner 0 and 1
  * \li neighbour or edge number of 1 is defined by corner 1 and 2
  * \li neighbour or edge number of 2 is defined by corner 2 and 0
- * \li neighbour index is set to ULONG_MAX if there is no neighbour facet
+ * \li neighbour index is set to FACET_INDEX_MAX if there is no neighbour facet
  *
  * Note: The status flag SEGMENT mark a facet to be part of certain subset, a segment.
  * This flag must not be set by any algorithm unless it adds or removes facets to a segment.
@@ -68,13 +92,28 @@ public:
   //@{
   inline MeshFacet (void);
   inline MeshFacet(const MeshFacet &rclF);
-  inline MeshFacet(unsigned long p1,unsigned long p2,unsigned long p3,unsigned long n1=ULONG_MAX,unsigned long n2=ULONG_MAX,unsigned long n3=ULONG_MAX);
+  inline MeshFacet(PointIndex p1,PointIndex p2,PointIndex p3,FacetIndex n1=FACET_INDEX_MAX,FacetIndex n2=FACET_INDEX_MAX,FacetIndex n3=FACET_INDEX_MAX);
   ~MeshFacet (void) { }
   //@}
 
+  /** @name Flag state */
+  //@{
+  void SetFlag (TFlagType tF) const
+  { const_cast<MeshFacet*>(this)->_ucFlag |= static_cast<unsigned char>(tF); }
   void ResetFlag (TFlagType tF) const
   { const_cast<MeshFacet*>(this)->_ucFlag &= ~static_cast<unsigned char>(tF); }
-  
+  bool IsFlag (TFlagType tF) const
+  { return (_ucFlag & static_cast<unsigned char>(tF)) == static_cast<unsigned char>(tF); }
+  bool IsValid (void) const
+  { return !IsFlag(INVALID); }
+  //@}
+
+  /**
+   * Checks if the facets \a rclFacet and this facet are oriented consistently,
+   * i.e. a common edge is traversed in opposite directions.
+   */
+  inline bool HasSameOrientation(const MeshFacet &rclFacet) const;
+
    void FlipNormal (void)
   {
     std::swap(_aulPoints[1], _aulPoints[2]);
@@ -82,11 +121,12 @@ public:
   }
 
   public:
-  unsigned long _aulPoints[3];     /**< Indices of corner points. */
-  unsigned long _aulNeighbours[3]; /**< Indices of neighbour facets. */
+  PointIndex _aulPoints[3];     /**< Indices of corner points. */
+  FacetIndex _aulNeighbours[3]; /**< Indices of neighbour facets. */
+  unsigned char _ucFlag;        /**< Flag member. */
 };
 
-typedef  std::vector<MeshPoint>  TMeshPointArray;
+typedef  std::vector<MeshPoint, MeshAllocator<MeshPoint> >  TMeshPointArray;
 /**
  * Stores all data points of the mesh structure.
  */
@@ -94,26 +134,38 @@ class MeshExport MeshPointArray: public TMeshPointArray
 {
 public:
   // Iterator interface
-  typedef std::vector<MeshPoint>::iterator        _TIterator;
-  typedef std::vector<MeshPoint>::const_iterator  _TConstIterator;
+  typedef TMeshPointArray::iterator        _TIterator;
+  typedef TMeshPointArray::const_iterator  _TConstIterator;
 
   /** @name Construction */
   //@{
   // constructor
   MeshPointArray (void) { }
   // constructor
-  MeshPointArray (unsigned long ulSize) : TMeshPointArray(ulSize) { }
+  MeshPointArray (PointIndex ulSize) : TMeshPointArray(ulSize) { }
+  /// constructor, the elements are placed into the storage of \a alloc
+  MeshPointArray (PointIndex ulSize, const allocator_type& alloc) : TMeshPointArray(ulSize, alloc) { }
   /// copy-constructor
   MeshPointArray (const MeshPointArray&);
+  /// move-constructor, takes the memory of \a ary
+  MeshPointArray (MeshPointArray&& ary) noexcept : TMeshPointArray(std::move(ary)) { }
   // Destructor
   ~MeshPointArray (void) { }
   //@}
 
+  /** @name Assignment */
+  //@{
+  MeshPointArray& operator = (const MeshPointArray&);
+  /// takes the memory of \a ary
+  MeshPointArray& operator = (MeshPointArray&& ary) noexcept
+  { TMeshPointArray::operator = (std::move(ary)); return *this; }
+  //@}
+
 };
 
 
 
-typedef std::vector<MeshFacet>  TMeshFacetArray;
+typedef std::vector<MeshFacet, MeshAllocator<MeshFacet> >  TMeshFacetArray;
 
 /**
  * Stores all facets of the mesh data-structure.
@@ -122,21 +174,33 @@ class MeshExport MeshFacetArray: public TMeshFacetArray
 {
 public:
     // Iterator interface
-    typedef std::vector<MeshFacet>::iterator        _TIterator;
-    typedef std::vector<MeshFacet>::const_iterator  _TConstIterator;
+    typedef TMeshFacetArray::iterator        _TIterator;
+    typedef TMeshFacetArray::const_iterator  _TConstIterator;
 
     /** @name Construction */
     //@{
     /// constructor
     MeshFacetArray (void) { }
     /// constructor
-    MeshFacetArray (unsigned long ulSize) : TMeshFacetArray(ulSize) { }
+    MeshFacetArray (FacetIndex ulSize) : TMeshFacetArray(ulSize) { }
+    /// constructor, the elements are placed into the storage of \a alloc
+    MeshFacetArray (FacetIndex ulSize, const allocator_type& alloc) : TMeshFacetArray(ulSize, alloc) { }
     /// copy-constructor
     MeshFacetArray (const MeshFacetArray&);
+    /// move-constructor, takes the memory of \a ary
+    MeshFacetArray (MeshFacetArray&& ary) noexcept : TMeshFacetArray(std::move(ary)) { }
     /// destructor
     ~MeshFacetArray (void) { }
     //@}
 
+    /** @name Assignment */
+    //@{
+    MeshFacetArray& operator = (const MeshFacetArray&);
+    /// takes the memory of \a ary
+    MeshFacetArray& operator = (MeshFacetArray&& ary) noexcept
+    { TMeshFacetArray::operator = (std::move(ary)); return *this; }
+    //@}
+
     /// Resets the flag for all facets. 
     void ResetFlag (MeshFacet::TFlagType tF) const;
 };
@@ -155,6 +219,54 @@ public:
     { return !rclElem.IsFlag(tFlag); }
 };
 
+inline MeshFacet::MeshFacet (void)
+  : _ucFlag(0)
+{
+  memset(_aulNeighbours, 0xff, sizeof(FacetIndex) * 3);
+  memset(_aulPoints, 0xff, sizeof(PointIndex) * 3);
+}
+
+inline MeshFacet::MeshFacet(const MeshFacet &rclF)
+  : _ucFlag(rclF._ucFlag)
+{
+  _aulPoints[0] = rclF._aulPoints[0];
+  _aulPoints[1] = rclF._aulPoints[1];
+  _aulPoints[2] = rclF._aulPoints[2];
+
+  _aulNeighbours[0] = rclF._aulNeighbours[0];
+  _aulNeighbours[1] = rclF._aulNeighbours[1];
+  _aulNeighbours[2] = rclF._aulNeighbours[2];
+}
+
+inline MeshFacet::MeshFacet(PointIndex p1,PointIndex p2,PointIndex p3,
+                            FacetIndex n1,FacetIndex n2,FacetIndex n3)
+  : _ucFlag(0)
+{
+  _aulPoints[0] = p1;
+  _aulPoints[1] = p2;
+  _aulPoints[2] = p3;
+
+  _aulNeighbours[0] = n1;
+  _aulNeighbours[1] = n2;
+  _aulNeighbours[2] = n3;
+}
+
+inline bool MeshFacet::HasSameOrientation(const MeshFacet& f) const
+{
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      if (_aulPoints[i] == f._aulPoints[j]) {
+        if ((_aulPoints[(i+1)%3] == f._aulPoints[(j+1)%3]) ||
+            (_aulPoints[(i+2)%3] == f._aulPoints[(j+2)%3])) {
+          return false; // adjacent face with wrong orientation
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
 } // namespace MeshCore
 
 #endif // MESH_ELEMENTS_H 
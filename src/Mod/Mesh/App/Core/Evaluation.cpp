@@ -25,6 +25,9 @@
 
 #ifndef _PreComp_
 # include <algorithm>
+# include <atomic>
+# include <functional>
+# include <memory>
 # include <vector>
 #endif
 
@@ -40,6 +43,10 @@
 #include "Grid.h"
 #include "TopoAlgorithm.h"
 #include "Functional.h"
+#include "ThreadPool.h"
+#include "Trace.h"
+#include "TopologyCache.h"
+#include "Traversal.h"
 #include <Base/Matrix.h>
 
 #include <Base/Sequencer.h>
@@ -50,18 +57,90 @@ MeshOrientationVisitor::MeshOrientationVisitor() : _nonuniformOrientation(false)
 {
 }
 
-MeshOrientationCollector::MeshOrientationCollector(std::vector<unsigned long>& aulIndices, std::vector<unsigned long>& aulComplement)
- : _aulIndices(aulIndices), _aulComplement(aulComplement)
+bool MeshOrientationVisitor::Visit (const MeshFacet &rclFacet, const MeshFacet &rclFrom,
+                                    FacetIndex ulFInd, unsigned long ulLevel)
 {
+    (void)ulFInd;
+    (void)ulLevel;
+    if (!rclFrom.HasSameOrientation(rclFacet)) {
+        _nonuniformOrientation = true;
+        return false;
+    }
+
+    return true;
+}
+
+bool MeshOrientationVisitor::HasNonUnifomOrientedFacets() const
+{
+    return _nonuniformOrientation;
 }
 
-MeshSameOrientationCollector::MeshSameOrientationCollector(std::vector<unsigned long>& aulIndices)
+MeshOrientationCollector::MeshOrientationCollector(const MeshFacetArray& rclFacets, FlagBitmap& rclWrong,
+                                                   std::vector<FacetIndex>& aulIndices, std::vector<FacetIndex>& aulComplement)
+ : _rclFacets(rclFacets), _rclWrong(rclWrong), _aulIndices(aulIndices), _aulComplement(aulComplement)
+ , _pool(nullptr)
+{
+}
+
+bool MeshOrientationCollector::VisitRing (const std::vector<FacetIndex>& rclRing,
+                                          const std::vector<FacetIndex>& rclFrom, unsigned long ulLevel)
+{
+    (void)ulLevel;
+    // the facets of the previous ring are already classified, so the facets of
+    // this ring can be classified independently
+    const std::size_t ulSize = rclRing.size();
+    _aucRingWrong.resize(ulSize);
+    ParallelFor(_pool, 0, ulSize, GrainSize(_pool, ulSize, 4096), [&](std::size_t b, std::size_t e) {
+        for (std::size_t k = b; k < e; k++) {
+            FacetIndex ulFInd = rclRing[k];
+            FacetIndex ulFrom = rclFrom[k];
+            // false oriented if it differs from a correct facet or matches a false oriented one
+            bool wrong = _rclFacets[ulFInd].HasSameOrientation(_rclFacets[ulFrom]) == _rclWrong.Test(ulFrom);
+            if (wrong)
+                _rclWrong.SetAtomic(ulFInd);
+            _aucRingWrong[k] = wrong ? 1 : 0;
+        }
+    });
+
+    for (std::size_t k = 0; k < ulSize; k++) {
+        if (_aucRingWrong[k])
+            _aulIndices.push_back(rclRing[k]);
+        else
+            _aulComplement.push_back(rclRing[k]);
+    }
+
+    return true;
+}
+
+MeshSameOrientationCollector::MeshSameOrientationCollector(std::vector<FacetIndex>& aulIndices)
   : _aulIndices(aulIndices)
 {
 }
 
+MeshOrientationWorkspace::MeshOrientationWorkspace (void)
+  : _ulClaims(0)
+{
+}
+
+MeshOrientationWorkspace::~MeshOrientationWorkspace (void)
+{
+}
+
+void MeshOrientationWorkspace::Clear (void)
+{
+    _visited.Release();
+    _wrong.Release();
+    std::vector<FacetIndex>* buffers[] = { &_aulIndices, &_aulComplement, &_aulFalsePos, &_aulOthers,
+                                           &_aulBorder, &_aulCurrent, &_aulNext, &_aulSeeds };
+    for (std::vector<FacetIndex>* buffer : buffers)
+        std::vector<FacetIndex>().swap(*buffer);
+    std::vector<Batch>().swap(_aclBatches);
+    _aClaims.reset();
+    _ulClaims = 0;
+}
+
 MeshEvalOrientation::MeshEvalOrientation (const MeshKernel& rclM)
-  : MeshEvaluation( rclM )
+  : MeshEvaluation( rclM ), _pool(nullptr), _trace(nullptr), _workspace(nullptr), _ulComponents(0)
 {
 }
 
@@ -69,65 +148,194 @@ MeshEvalOrientation::~MeshEvalOrientation()
 {
 }
 
-unsigned long MeshEvalOrientation::HasFalsePositives(const std::vector<unsigned long>& inds) const
+FacetIndex MeshEvalOrientation::HasFalsePositives(const std::vector<FacetIndex>& inds) const
 {
     // All faces with wrong orientation (i.e. adjacent faces with a normal flip and their neighbours)
-    // build a segment and are marked as TMP0. Now we check all border faces of the segments with 
+    // build a segment and are marked in '_wrong'. Now we check all border faces of the segments with 
     // their correct neighbours if there was really a normal flip. If there is no normal flip we have
     // a false positive.
     // False-positives can occur if the mesh structure has some defects which let the region-grow
     // algorithm fail to detect the faces with wrong orientation.
+    const FlagBitmap& wrong = Workspace()._wrong;
+    for (std::vector<FacetIndex>::const_iterator it = inds.begin(); it != inds.end(); ++it) {
+        if (wrong.Test(*it)) {
+            FacetIndex ulNeighbour = FalsePositiveNeighbour(*it);
+            if (ulNeighbour != FACET_INDEX_MAX)
+                return ulNeighbour;
+        }
+    }
+
+    return FACET_INDEX_MAX;
+}
+
+FacetIndex MeshEvalOrientation::FalsePositiveNeighbour(FacetIndex ulFacet) const
+{
     const MeshFacetArray& rFAry = _rclMesh.GetFacets();
-    MeshFacetArray::_TConstIterator iBeg = rFAry.begin();
-    for (std::vector<unsigned long>::const_iterator it = inds.begin(); it != inds.end(); ++it) {
-        const MeshFacet& f = iBeg[*it];
-        for (int i = 0; i < 3; i++) {
-            if (f._aulNeighbours[i] != ULONG_MAX) {
-                const MeshFacet& n = iBeg[f._aulNeighbours[i]];
-                if (f.IsFlag(MeshFacet::TMP0) && !n.IsFlag(MeshFacet::TMP0)) {
-                    for (int j = 0; j < 3; j++) {
-                        if (f.HasSameOrientation(n)) {
-                            // adjacent face with same orientation => false positive
-                            return f._aulNeighbours[i];
-                        }
-                    }
-                }
-            }
+    const FlagBitmap& wrong = Workspace()._wrong;
+    const MeshFacet& f = rFAry[ulFacet];
+    for (int i = 0; i < 3; i++) {
+        FacetIndex ulNeighbour = f._aulNeighbours[i];
+        if (ulNeighbour >= rFAry.size())
+            continue; // open edge or error in data structure
+        if (!wrong.Test(ulNeighbour) && f.HasSameOrientation(rFAry[ulNeighbour])) {
+            // adjacent face with same orientation => false positive
+            return ulNeighbour;
         }
     }
 
-    return ULONG_MAX;
+    return FACET_INDEX_MAX;
 }
 
+namespace {
+/**
+ * Collects the facets of the traversed region that have the same orientation as
+ * the facet they are reached from, and all other facets of the region.
+ */
+class FalsePositiveCollector
+{
+public:
+    FalsePositiveCollector(std::vector<FacetIndex>& falsePos, std::vector<FacetIndex>& others)
+      : _falsePos(falsePos), _others(others)
+    {
+    }
+
+    bool Visit (const MeshFacet &rclFacet, const MeshFacet &rclFrom,
+                FacetIndex ulFInd, unsigned long)
+    {
+        if (rclFacet.HasSameOrientation(rclFrom))
+            _falsePos.push_back(ulFInd);
+        else
+            _others.push_back(ulFInd);
+        return true;
+    }
+
+private:
+    std::vector<FacetIndex>& _falsePos;
+    std::vector<FacetIndex>& _others;
+};
+}
 
-std::vector<unsigned long> MeshEvalOrientation::GetIndices() const
+void MeshEvalOrientation::CorrectFalsePositives(std::vector<FacetIndex>& uIndices, FacetIndex ulStartFacet) const
 {
-    unsigned long ulStartFacet, ulVisited;
+    const MeshFacetArray& rFAry = _rclMesh.GetFacets();
+    MeshOrientationWorkspace& ws = Workspace();
+    FlagBitmap& visited = ws._visited;
+    FlagBitmap& wrong = ws._wrong;
 
-    if (_rclMesh.CountFacets() == 0)
-        return std::vector<unsigned long>();
+    // Only the false oriented facets are unvisited, thus a traversal from a correct
+    // facet covers exactly the false oriented region it borders.
+    for (std::vector<FacetIndex>::iterator it = uIndices.begin(); it != uIndices.end(); ++it)
+        visited.Reset(*it);
+
+    // False oriented facets with a false positive neighbour as heap, the smallest index
+    // on top. Facets only ever leave the false oriented set, so a facet keeps such a
+    // neighbour until it leaves the set itself, then it is dropped lazily.
+    std::vector<FacetIndex>& border = ws._aulBorder;
+    const std::greater<FacetIndex> borderOrder;
+    border.clear();
+    bool oneSided = false;
+    for (std::vector<FacetIndex>::iterator it = uIndices.begin(); it != uIndices.end(); ++it) {
+        if (FalsePositiveNeighbour(*it) != FACET_INDEX_MAX) {
+            border.push_back(*it);
+            std::push_heap(border.begin(), border.end(), borderOrder);
+        }
+        const MeshFacet& f = rFAry[*it];
+        for (int i = 0; i < 3; i++) {
+            FacetIndex j = f._aulNeighbours[i];
+            if (j < rFAry.size() && rFAry[j]._aulNeighbours[0] != *it &&
+                rFAry[j]._aulNeighbours[1] != *it && rFAry[j]._aulNeighbours[2] != *it)
+                oneSided = true;
+        }
+    }
+
+    // With a one-sided neighbourhood a corrected facet does not know all facets it
+    // borders, so the remaining false oriented facets are scanned in each iteration.
+    if (oneSided)
+        std::sort(uIndices.begin(), uIndices.end());
+
+    std::vector<FacetIndex>& falsePos = ws._aulFalsePos;
+    std::vector<FacetIndex>& others = ws._aulOthers;
+    FalsePositiveCollector coll(falsePos, others);
+    MeshFacetTraversal traversal(rFAry);
+    traversal.SwapBuffers(ws._aulCurrent, ws._aulNext);
+    while (ulStartFacet != FACET_INDEX_MAX) {
+        MESH_TRACE_COUNT(_trace, FalsePositiveIterations, 1);
+        falsePos.clear();
+        others.clear();
+        traversal.VisitNeighbours(coll, ulStartFacet, visited);
 
-    // reset VISIT flags
-    MeshAlgorithm cAlg(_rclMesh);
-    cAlg.ResetFacetFlag(MeshFacet::VISIT);
-    cAlg.ResetFacetFlag(MeshFacet::TMP0);
+        for (std::vector<FacetIndex>::iterator it = falsePos.begin(); it != falsePos.end(); ++it)
+            wrong.Reset(*it);
+        for (std::vector<FacetIndex>::iterator it = others.begin(); it != others.end(); ++it)
+            visited.Reset(*it);
 
+        FacetIndex current = ulStartFacet;
+        if (oneSided) {
+            uIndices.erase(std::remove_if(uIndices.begin(), uIndices.end(),
+                                          [&wrong](FacetIndex i) { return !wrong.Test(i); }), uIndices.end());
+            ulStartFacet = HasFalsePositives(uIndices);
+            if (current == ulStartFacet)
+                break; // avoid an endless loop
+            continue;
+        }
+
+        // only the neighbours of the corrected facets can get a false positive neighbour
+        for (std::vector<FacetIndex>::iterator it = falsePos.begin(); it != falsePos.end(); ++it) {
+            const MeshFacet& f = rFAry[*it];
+            for (int i = 0; i < 3; i++) {
+                FacetIndex ulNeighbour = f._aulNeighbours[i];
+                if (ulNeighbour < rFAry.size() && wrong.Test(ulNeighbour) &&
+                    FalsePositiveNeighbour(ulNeighbour) != FACET_INDEX_MAX) {
+                    border.push_back(ulNeighbour);
+                    std::push_heap(border.begin(), border.end(), borderOrder);
+                }
+            }
+        }
+
+        ulStartFacet = FACET_INDEX_MAX;
+        while (!border.empty()) {
+            if (wrong.Test(border.front())) {
+                ulStartFacet = FalsePositiveNeighbour(border.front());
+                break;
+            }
+            std::pop_heap(border.begin(), border.end(), borderOrder);
+            border.pop_back();
+        }
+        if (current == ulStartFacet)
+            break; // avoid an endless loop
+    }
+    traversal.SwapBuffers(ws._aulCurrent, ws._aulNext);
+
+    // once corrected the indices are returned in ascending order
+    uIndices.erase(std::remove_if(uIndices.begin(), uIndices.end(),
+                                  [&wrong](FacetIndex i) { return !wrong.Test(i); }), uIndices.end());
+    std::sort(uIndices.begin(), uIndices.end());
+}
+
+
+void MeshEvalOrientation::CollectIndices(std::vector<FacetIndex>& uIndices) const
+{
+    MESH_TRACE_SCOPE(_trace, "RegionGrowing");
     const MeshFacetArray& rFAry = _rclMesh.GetFacets();
-    MeshFacetArray::_TConstIterator iTri = rFAry.begin();
-    MeshFacetArray::_TConstIterator iBeg = rFAry.begin();
-    MeshFacetArray::_TConstIterator iEnd = rFAry.end();
+    MeshOrientationWorkspace& ws = Workspace();
 
-    ulStartFacet = 0;
+    FacetIndex ulStartFacet = 0;
+    unsigned long ulVisited;
 
-    std::vector<unsigned long> uIndices, uComplement;
-    MeshOrientationCollector clHarmonizer(uIndices, uComplement);
+    std::vector<FacetIndex>& uComplement = ws._aulComplement;
+    MeshOrientationCollector clHarmonizer(rFAry, ws._wrong, uIndices, uComplement);
+    MeshFacetTraversal traversal(rFAry);
+    traversal.SwapBuffers(ws._aulCurrent, ws._aulNext);
 
-    while (ulStartFacet !=  ULONG_MAX) { 
+    while (ulStartFacet !=  FACET_INDEX_MAX) { 
         unsigned long wrongFacets = uIndices.size();
 
         uComplement.clear();
         uComplement.push_back( ulStartFacet );
-        ulVisited = _rclMesh.VisitNeighbourFacets(clHarmonizer, ulStartFacet) + 1;
+        ulVisited = traversal.VisitNeighbours(clHarmonizer, ulStartFacet, ws._visited) + 1;
+        _ulComponents++;
+        MESH_TRACE_COUNT(_trace, ComponentsVisited, 1);
+        MESH_TRACE_COUNT(_trace, FacetsVisited, ulVisited);
 
         // In the currently visited component we have found less than 40% as correct
         // oriented and the rest as false oriented. So, we decide that it should be the other
@@ -138,45 +346,415 @@ std::vector<unsigned long> MeshEvalOrientation::GetIndices() const
         }
 
         // if the mesh consists of several topologic independent components
-        // We can search from position 'iTri' on because all elements _before_ are already visited
+        // We can search from the last start facet on because all elements _before_ are already visited
         // what we know from the previous iteration.
-        MeshIsNotFlag<MeshFacet> flag;
-        iTri = std::find_if(iTri, iEnd, [flag](const MeshFacet& f) {
-            return flag(f, MeshFacet::VISIT);
+        ulStartFacet = ws._visited.FindFirstReset(ulStartFacet);
+        if (ulStartFacet >= rFAry.size())
+            ulStartFacet = FACET_INDEX_MAX;
+    }
+    traversal.SwapBuffers(ws._aulCurrent, ws._aulNext);
+}
+
+bool MeshEvalOrientation::CollectIndicesParallel(std::vector<FacetIndex>& uIndices, MeshTopologyCache& cache) const
+{
+    MESH_TRACE_SCOPE(_trace, "RegionGrowing");
+    const MeshFacetArray& rFAry = _rclMesh.GetFacets();
+    const FacetIndex ulCount = rFAry.size();
+    const std::size_t grain = GrainSize(_pool, ulCount, 4096);
+    MeshOrientationWorkspace& ws = Workspace();
+
+    // The components only depend on the topology and are kept in the cache. With a
+    // one-sided neighbourhood the reachable region depends on the start facet, so
+    // only the serial algorithm gives the right answer.
+    {
+        MESH_TRACE_SCOPE(_trace, "ComponentLabeling");
+        cache.Update(_rclMesh, _pool);
+    }
+    if (!cache.IsSymmetric())
+        return false;
+
+    // the seed of each component is the start facet the serial algorithm would pick
+    std::vector<FacetIndex>& seeds = ws._aulSeeds;
+    seeds.resize(cache.CountComponents());
+    for (unsigned long c = 0; c < seeds.size(); c++)
+        seeds[c] = cache.GetSeed(c);
+
+    if (ws._ulClaims < ulCount) {
+        ws._aClaims.reset();
+        ws._aClaims.reset(new std::atomic<FacetIndex>[ulCount]);
+        ws._ulClaims = ulCount;
+    }
+
+    // The claims of the parallel traversal. As the components are disjoint all
+    // batches can share them.
+    _ulComponents = seeds.size();
+    std::atomic<FacetIndex>* claims = ws._aClaims.get();
+    ParallelFor(_pool, 0, ulCount, grain, [&](std::size_t b, std::size_t e) {
+        for (std::size_t i = b; i < e; i++)
+            claims[i].store(FACET_INDEX_MAX, std::memory_order_relaxed);
+    });
+
+    // Harmonize batches of components concurrently. Each batch keeps its components in
+    // ascending order of their start facet so that concatenating the batches reproduces
+    // the serial result.
+    const std::size_t batch = GrainSize(_pool, seeds.size(), 1);
+    const std::size_t numBatches = (seeds.size() + batch - 1) / batch;
+    if (ws._aclBatches.size() < numBatches)
+        ws._aclBatches.resize(numBatches);
+
+    TaskGroup group(_pool);
+    for (std::size_t t = 0; t < numBatches; t++) {
+        group.Run([this, t, batch, &ws, claims]() {
+            MESH_TRACE_SCOPE(_trace, "RegionGrowingBatch");
+            const std::vector<FacetIndex>& seeds = ws._aulSeeds;
+            MeshOrientationWorkspace::Batch& slot = ws._aclBatches[t];
+            std::vector<FacetIndex>& result = slot.result;
+            std::vector<FacetIndex>& wrong = slot.wrong;
+            std::vector<FacetIndex>& complement = slot.complement;
+            result.clear();
+            MeshOrientationCollector clHarmonizer(_rclMesh.GetFacets(), ws._wrong, wrong, complement);
+            clHarmonizer.SetThreadPool(_pool);
+            // large rings of a component are expanded on the pool as well, bottom-up
+            // only if no other component is traversed at the same time
+            MeshParallelFacetTraversal traversal(_rclMesh.GetFacets(), _pool, claims);
+            traversal.SetBottomUp(seeds.size() == 1);
+
+            std::size_t end = std::min(seeds.size(), (t + 1) * batch);
+            for (std::size_t s = t * batch; s < end; s++) {
+                wrong.clear();
+                complement.clear();
+                complement.push_back(seeds[s]);
+                unsigned long ulVisited = traversal.VisitRings(clHarmonizer, seeds[s], ws._visited) + 1;
+                MESH_TRACE_COUNT(_trace, ComponentsVisited, 1);
+                MESH_TRACE_COUNT(_trace, FacetsVisited, ulVisited);
+
+                // same 40% rule as in the serial algorithm
+                if (complement.size() < static_cast<unsigned long>(0.4f*static_cast<float>(ulVisited)))
+                    result.insert(result.end(), complement.begin(), complement.end());
+                else
+                    result.insert(result.end(), wrong.begin(), wrong.end());
+            }
         });
+    }
+    group.Wait();
 
-        if (iTri < iEnd)
-            ulStartFacet = iTri - iBeg;
-        else
-            ulStartFacet = ULONG_MAX;
+    std::size_t total = 0;
+    for (std::size_t t = 0; t < numBatches; t++)
+        total += ws._aclBatches[t].result.size();
+    uIndices.reserve(total);
+    for (std::size_t t = 0; t < numBatches; t++)
+        uIndices.insert(uIndices.end(), ws._aclBatches[t].result.begin(), ws._aclBatches[t].result.end());
+
+    return true;
+}
+
+namespace {
+/**
+ * Uses the topology cache of the kernel, or a private one while another evaluation
+ * of the same kernel holds it.
+ */
+class TopologyCacheScope
+{
+public:
+    explicit TopologyCacheScope(MeshTopologyCache& rclShared)
+      : _rclShared(rclShared), _bOwner(rclShared.Acquire())
+    {
+        if (!_bOwner)
+            _pLocal.reset(new MeshTopologyCache());
+    }
+    ~TopologyCacheScope()
+    {
+        if (_bOwner)
+            _rclShared.Release();
     }
+    MeshTopologyCache& Get()
+    { return _bOwner ? _rclShared : *_pLocal; }
+
+private:
+    MeshTopologyCache& _rclShared;
+    bool _bOwner;
+    std::unique_ptr<MeshTopologyCache> _pLocal;
+};
+}
+
+std::vector<FacetIndex> MeshEvalOrientation::GetIndices() const
+{
+    std::vector<FacetIndex> uIndices;
+    GetIndices(uIndices);
+    return uIndices;
+}
+
+void MeshEvalOrientation::GetIndices(std::vector<FacetIndex>& uIndices) const
+{
+    MESH_TRACE_SCOPE(_trace, "GetIndices");
+    FacetIndex ulStartFacet;
+
+    uIndices.clear();
+    _ulComponents = 0;
+    if (_rclMesh.CountFacets() == 0)
+        return;
+
+    // nothing to do if the facets are unchanged since the last evaluation
+    TopologyCacheScope scope(_rclMesh.GetTopologyCache());
+    MeshTopologyCache& cache = scope.Get();
+    if (cache.GetOrientation(_rclMesh, uIndices, _ulComponents))
+        return;
+
+    // reset the marks
+    MeshOrientationWorkspace& ws = Workspace();
+    ws._visited.Resize(_rclMesh.CountFacets());
+    ws._wrong.Resize(_rclMesh.CountFacets());
+
+    if (!_pool || !CollectIndicesParallel(uIndices, cache))
+        CollectIndices(uIndices);
 
     // in some very rare cases where we have some strange artifacts in the mesh structure
     // we get false-positives. If we find some we check all 'invalid' faces again
-    cAlg.ResetFacetFlag(MeshFacet::TMP0);
-    cAlg.SetFacetsFlag(uIndices, MeshFacet::TMP0);
+    MESH_TRACE_SCOPE(_trace, "FalsePositives");
+    ws._wrong.Clear();
+    for (std::vector<FacetIndex>::iterator it = uIndices.begin(); it != uIndices.end(); ++it)
+        ws._wrong.Set(*it);
     ulStartFacet = HasFalsePositives(uIndices);
-    while (ulStartFacet != ULONG_MAX) {
-        cAlg.ResetFacetsFlag(uIndices, MeshFacet::VISIT);
-        std::vector<unsigned long> falsePos;
-        MeshSameOrientationCollector coll(falsePos);
-        _rclMesh.VisitNeighbourFacets(coll, ulStartFacet);
+    if (ulStartFacet != FACET_INDEX_MAX)
+        CorrectFalsePositives(uIndices, ulStartFacet);
 
-        std::sort(uIndices.begin(), uIndices.end());
-        std::sort(falsePos.begin(), falsePos.end());
+    cache.SetOrientation(_rclMesh, uIndices, _ulComponents);
+}
 
-        std::vector<unsigned long> diff;
-        std::back_insert_iterator<std::vector<unsigned long> > biit(diff);
-        std::set_difference(uIndices.begin(), uIndices.end(), falsePos.begin(), falsePos.end(), biit);
-        uIndices = diff;
 
-        cAlg.ResetFacetFlag(MeshFacet::TMP0);
-        cAlg.SetFacetsFlag(uIndices, MeshFacet::TMP0);
-        unsigned long current = ulStartFacet;
-        ulStartFacet = HasFalsePositives(uIndices);
-        if (current == ulStartFacet)
-            break; // avoid an endless loop
+MeshOrientationPlan::MeshOrientationPlan (const MeshKernel& rclM)
+  : _rclMesh(rclM), _pool(nullptr), _trace(nullptr), _workspace(nullptr)
+{
+    _clSummary.countFacets = 0;
+    _clSummary.countComponents = 0;
+    _clSummary.countFlipped = 0;
+    _clSummary.countRanges = 0;
+}
+
+MeshOrientationPlan::~MeshOrientationPlan ()
+{
+}
+
+void MeshOrientationPlan::Compute (void)
+{
+    MESH_TRACE_SCOPE(_trace, "OrientationPlan");
+    MeshOrientationWorkspace& ws = Workspace();
+    std::vector<FacetIndex>& uIndices = ws._aulIndices;
+
+    MeshEvalOrientation eval(_rclMesh);
+    eval.SetThreadPool(_pool);
+    eval.SetTrace(_trace);
+    eval.SetWorkspace(&ws);
+    eval.GetIndices(uIndices);
+    std::sort(uIndices.begin(), uIndices.end());
+
+    _clSummary.countFacets = _rclMesh.CountFacets();
+    _clSummary.countComponents = eval.CountComponents();
+    _clSummary.countFlipped = uIndices.size();
+    _clSummary.countRanges = 0;
+    for (std::size_t i = 0; i < uIndices.size(); i++) {
+        if (i == 0 || uIndices[i] != uIndices[i - 1] + 1)
+            _clSummary.countRanges++;
+    }
+}
+
+std::size_t MeshOrientationPlan::WriteBitmap (uint64_t* pWords, std::size_t ulWords) const
+{
+    const std::size_t ulCount = std::min(ulWords, CountBitmapWords());
+    std::fill(pWords, pWords + ulCount, uint64_t(0));
+    const std::vector<FacetIndex>& uIndices = GetIndices();
+    for (std::vector<FacetIndex>::const_iterator it = uIndices.begin(); it != uIndices.end(); ++it) {
+        if (*it / 64 >= ulCount)
+            break; // ascending order
+        pWords[*it / 64] |= uint64_t(1) << (*it % 64);
     }
+    return CountBitmapWords();
+}
 
-    return uIndices;
+// ----------------------------------------------------------------------------
+
+namespace {
+// Lock-free union-find with parity bits. An entry holds the parent shifted by one bit
+// and the parity of the element relative to its parent. A root is always the smallest
+// index of its set and has parity 0. As the parity between an element and any of its
+// ancestors never changes, entries can be compressed concurrently.
+typedef std::atomic<uint64_t> ParityEntry;
+
+FacetIndex FindParityRoot(ParityEntry* entries, FacetIndex i, unsigned int& parity)
+{
+    parity = 0;
+    for (;;) {
+        uint64_t e = entries[i].load(std::memory_order_relaxed);
+        FacetIndex p = static_cast<FacetIndex>(e >> 1);
+        if (p == i)
+            return i;
+        uint64_t pe = entries[p].load(std::memory_order_relaxed);
+        FacetIndex gp = static_cast<FacetIndex>(pe >> 1);
+        unsigned int toGrandParent = static_cast<unsigned int>((e ^ pe) & 1);
+        if (p != gp) {
+            uint64_t expected = e;
+            entries[i].compare_exchange_weak(expected, (static_cast<uint64_t>(gp) << 1) | toGrandParent,
+                                             std::memory_order_relaxed); // path halving
+        }
+        parity ^= toGrandParent;
+        i = gp;
+    }
+}
+
+// Merges the sets of 'a' and 'b' so that their parities differ by 'relation'.
+// Returns false if they already are in one set with the other relation.
+bool UniteParity(ParityEntry* entries, FacetIndex a, FacetIndex b, unsigned int relation)
+{
+    for (;;) {
+        unsigned int pa, pb;
+        a = FindParityRoot(entries, a, pa);
+        b = FindParityRoot(entries, b, pb);
+        relation ^= pa ^ pb; // now the relation between the roots
+        if (a == b)
+            return relation == 0;
+        if (a > b)
+            std::swap(a, b);
+        // link the larger root to the smaller one, retry if 'b' got linked meanwhile
+        uint64_t expected = static_cast<uint64_t>(b) << 1;
+        if (entries[b].compare_exchange_strong(expected, (static_cast<uint64_t>(a) << 1) | relation))
+            return true;
+    }
+}
+}
+
+MeshEvalOrientationParity::MeshEvalOrientationParity (const MeshKernel& rclM)
+  : MeshEvaluation( rclM ), _pool(nullptr), _trace(nullptr)
+{
+}
+
+MeshEvalOrientationParity::~MeshEvalOrientationParity()
+{
+}
+
+bool MeshEvalOrientationParity::GetIndices(std::vector<FacetIndex>& uIndices) const
+{
+    MESH_TRACE_SCOPE(_trace, "ParityUnionFind");
+    uIndices.clear();
+    const MeshFacetArray& rFAry = _rclMesh.GetFacets();
+    const FacetIndex ulCount = rFAry.size();
+    if (ulCount == 0)
+        return true;
+    const std::size_t grain = GrainSize(_pool, ulCount, 4096);
+
+    std::unique_ptr<ParityEntry[]> entries(new ParityEntry[ulCount]);
+    ParallelFor(_pool, 0, ulCount, grain, [&](std::size_t b, std::size_t e) {
+        for (std::size_t i = b; i < e; i++)
+            entries[i].store(static_cast<uint64_t>(i) << 1, std::memory_order_relaxed);
+    });
+
+    // a facet must be flipped relative to its neighbour if they are not oriented the same way
+    std::atomic<bool> unsolvable(false);
+    {
+        MESH_TRACE_SCOPE(_trace, "ParityConstraints");
+        ParallelFor(_pool, 0, ulCount, grain, [&](std::size_t b, std::size_t e) {
+            for (FacetIndex i = b; i < e; i++) {
+                const MeshFacet& f = rFAry[i];
+                for (int k = 0; k < 3; k++) {
+                    FacetIndex j = f._aulNeighbours[k];
+                    if (j >= ulCount)
+                        continue; // open edge or error in data structure
+                    const MeshFacet& n = rFAry[j];
+                    if (n._aulNeighbours[0] != i && n._aulNeighbours[1] != i && n._aulNeighbours[2] != i) {
+                        // one-sided neighbourhood: the region growing depends on the start facet
+                        unsolvable = true;
+                        return;
+                    }
+                    if (j > i && !UniteParity(entries.get(), i, j, f.HasSameOrientation(n) ? 0 : 1)) {
+                        // not orientable: the region growing depends on the traversal order
+                        unsolvable = true;
+                        return;
+                    }
+                }
+                if (unsolvable.load(std::memory_order_relaxed))
+                    return;
+            }
+        });
+    }
+
+    if (unsolvable)
+        return false;
+
+    // Flatten the sets and count the facets of each component and those with another
+    // parity than the root. Consecutive facets mostly share their root, so the counts
+    // are summed up locally and only added to the root when it changes.
+    std::unique_ptr<std::atomic<FacetIndex>[]> sizes(new std::atomic<FacetIndex>[ulCount]);
+    std::unique_ptr<std::atomic<FacetIndex>[]> ones(new std::atomic<FacetIndex>[ulCount]);
+    ParallelFor(_pool, 0, ulCount, grain, [&](std::size_t b, std::size_t e) {
+        for (std::size_t i = b; i < e; i++) {
+            sizes[i].store(0, std::memory_order_relaxed);
+            ones[i].store(0, std::memory_order_relaxed);
+        }
+    });
+    ParallelFor(_pool, 0, ulCount, grain, [&](std::size_t b, std::size_t e) {
+        FacetIndex root = FACET_INDEX_MAX, size = 0, odd = 0;
+        for (FacetIndex i = b; i < e; i++) {
+            unsigned int parity;
+            FacetIndex r = FindParityRoot(entries.get(), i, parity);
+            entries[i].store((static_cast<uint64_t>(r) << 1) | parity, std::memory_order_relaxed);
+            if (r != root) {
+                if (root != FACET_INDEX_MAX) {
+                    sizes[root].fetch_add(size, std::memory_order_relaxed);
+                    ones[root].fetch_add(odd, std::memory_order_relaxed);
+                }
+                root = r;
+                size = odd = 0;
+            }
+            size++;
+            odd += parity;
+        }
+        sizes[root].fetch_add(size, std::memory_order_relaxed);
+        ones[root].fetch_add(odd, std::memory_order_relaxed);
+    });
+
+    // Decide each component with the same 40% rule as the region growing, which
+    // starts at the root. The decision is kept in the parity bit of the root.
+    std::atomic<unsigned long> components(0);
+    ParallelFor(_pool, 0, ulCount, grain, [&](std::size_t b, std::size_t e) {
+        unsigned long roots = 0;
+        for (FacetIndex i = b; i < e; i++) {
+            if ((entries[i].load(std::memory_order_relaxed) >> 1) != i)
+                continue;
+            roots++;
+            unsigned long ulVisited = sizes[i].load(std::memory_order_relaxed);
+            unsigned long ulComplement = ulVisited - ones[i].load(std::memory_order_relaxed);
+            if (ulComplement < static_cast<unsigned long>(0.4f*static_cast<float>(ulVisited)))
+                entries[i].store((static_cast<uint64_t>(i) << 1) | 1, std::memory_order_relaxed);
+        }
+        components += roots;
+    });
+    sizes.reset();
+    ones.reset();
+    MESH_TRACE_COUNT(_trace, ComponentsVisited, components.load());
+    MESH_TRACE_COUNT(_trace, FacetsVisited, ulCount);
+
+    // a facet is false oriented if its parity differs from the decision of its component
+    const std::size_t numChunks = (ulCount + grain - 1) / grain;
+    std::vector<std::vector<FacetIndex> > results(numChunks);
+    ParallelFor(_pool, 0, numChunks, 1, [&](std::size_t b, std::size_t e) {
+        for (std::size_t c = b; c < e; c++) {
+            FacetIndex end = static_cast<FacetIndex>(std::min<std::size_t>(ulCount, (c + 1) * grain));
+            for (FacetIndex i = static_cast<FacetIndex>(c * grain); i < end; i++) {
+                uint64_t entry = entries[i].load(std::memory_order_relaxed);
+                FacetIndex r = static_cast<FacetIndex>(entry >> 1);
+                uint64_t parity = r == i ? 0 : (entry & 1);
+                uint64_t decision = entries[r].load(std::memory_order_relaxed) & 1;
+                if (parity != decision)
+                    results[c].push_back(i);
+            }
+        }
+    });
+
+    std::size_t total = 0;
+    for (std::vector<std::vector<FacetIndex> >::iterator it = results.begin(); it != results.end(); ++it)
+        total += it->size();
+    uIndices.reserve(total);
+    for (std::vector<std::vector<FacetIndex> >::iterator it = results.begin(); it != results.end(); ++it)
+        uIndices.insert(uIndices.end(), it->begin(), it->end());
+
+    return true;
 }
@@ -24,14 +24,21 @@
 #ifndef MESH_EVALUATION_H
 #define MESH_EVALUATION_H
 
+#include <atomic>
+#include <cstdint>
 #include <list>
 #include <cmath>
+#include <memory>
 
 #include "MeshKernel.h"
 #include "Visitor.h"
+#include "FlagBitmap.h"
 
 namespace MeshCore {
 
+class MeshTrace;
+class ThreadPool;
+
 /**
  * The MeshEvaluation class checks the mesh kernel for correctness with respect to a
  * certain criterion, such as manifoldness, self-intersections, etc.
@@ -60,7 +67,10 @@ class MeshExport MeshOrientationVisitor : public MeshFacetVisitor
 public:
     MeshOrientationVisitor();
 
-   
+    /** Returns false after the first inconsistently oriented facet has been found. */
+    bool Visit (const MeshFacet &rclFacet, const MeshFacet &rclFrom,
+                FacetIndex ulFInd, unsigned long ulLevel);
+    bool HasNonUnifomOrientedFacets() const;
 
 private:
     bool _nonuniformOrientation;
@@ -68,36 +78,146 @@ private:
 
 /**
  * This class searches for inconsistent orientation of neighboured facets.
- * Note: The 'TMP0' flag for facets must be reset before using this class.
+ * The facets found as false oriented are marked in \a rclWrong which must be
+ * cleared before using this class. \a rclFacets must be the facet array of the
+ * traversed kernel.
  * @author Werner Mayer
  */
-class MeshExport MeshOrientationCollector : public MeshOrientationVisitor
+class MeshExport MeshOrientationCollector final : public MeshOrientationVisitor
 {
 public:
-    MeshOrientationCollector(std::vector<unsigned long>& aulIndices,
-                             std::vector<unsigned long>& aulComplement);
+    MeshOrientationCollector(const MeshFacetArray& rclFacets, FlagBitmap& rclWrong,
+                             std::vector<FacetIndex>& aulIndices,
+                             std::vector<FacetIndex>& aulComplement);
+
+    /** Inline and final, so that MeshFacetTraversal can inline it. */
+    bool Visit (const MeshFacet &rclFacet, const MeshFacet &rclFrom,
+                FacetIndex ulFInd, unsigned long ulLevel) override
+    {
+        (void)ulLevel;
+        // both facets are elements of the traversed array
+        FacetIndex ulFrom = static_cast<FacetIndex>(&rclFrom - &_rclFacets[0]);
+
+        // different orientation of rclFacet and rclFrom
+        if (!rclFacet.HasSameOrientation(rclFrom)) {
+            // is not marked as false oriented
+            if (!_rclWrong.Test(ulFrom)) {
+                // mark this facet as false oriented
+                _rclWrong.Set(ulFInd);
+                _aulIndices.push_back(ulFInd);
+            }
+            else
+                _aulComplement.push_back(ulFInd);
+        }
+        else {
+            // same orientation but if the neighbour rclFrom is false oriented
+            // then this is also false oriented
+            if (_rclWrong.Test(ulFrom)) {
+                // mark this facet as false oriented
+                _rclWrong.Set(ulFInd);
+                _aulIndices.push_back(ulFInd);
+            }
+            else
+                _aulComplement.push_back(ulFInd);
+        }
 
+        return true;
+    }
+
+    /**
+     * Does the same as Visit() for a whole ring of MeshParallelFacetTraversal, where
+     * \a rclFrom holds the facets the ring facets are reached from. The facets are
+     * classified on the thread pool if one is set.
+     */
+    bool VisitRing (const std::vector<FacetIndex>& rclRing, const std::vector<FacetIndex>& rclFrom,
+                    unsigned long ulLevel);
+    void SetThreadPool (ThreadPool* pool)
+    { _pool = pool; }
 
 private:
-    std::vector<unsigned long>& _aulIndices;
-    std::vector<unsigned long>& _aulComplement;
+    const MeshFacetArray& _rclFacets;
+    FlagBitmap& _rclWrong;
+    std::vector<FacetIndex>& _aulIndices;
+    std::vector<FacetIndex>& _aulComplement;
+    ThreadPool* _pool;
+    std::vector<unsigned char> _aucRingWrong;
 };
 
 /**
  * @author Werner Mayer
  */
-class MeshExport MeshSameOrientationCollector : public MeshOrientationVisitor
+class MeshExport MeshSameOrientationCollector final : public MeshOrientationVisitor
 {
 public:
-    MeshSameOrientationCollector(std::vector<unsigned long>& aulIndices);
-  
+    MeshSameOrientationCollector(std::vector<FacetIndex>& aulIndices);
+
+    bool Visit (const MeshFacet &rclFacet, const MeshFacet &rclFrom,
+                FacetIndex ulFInd, unsigned long ulLevel) override
+    {
+        (void)ulLevel;
+        if (rclFacet.HasSameOrientation(rclFrom))
+            _aulIndices.push_back(ulFInd);
+        return true;
+    }
 
 private:
-    std::vector<unsigned long>& _aulIndices;
+    std::vector<FacetIndex>& _aulIndices;
+};
+
+/**
+ * The MeshOrientationWorkspace class holds the scratch memory of MeshEvalOrientation
+ * and MeshTopoAlgorithm::HarmonizeNormals(). Its buffers only grow, so if a workspace
+ * is reused for many evaluations, e.g. by a batch worker, the serial region growing
+ * allocates memory only for meshes larger than all meshes before. A workspace must
+ * not be used by two evaluations at the same time.
+ */
+class MeshExport MeshOrientationWorkspace
+{
+public:
+    MeshOrientationWorkspace (void);
+    ~MeshOrientationWorkspace (void);
+
+    /** Releases all memory. */
+    void Clear (void);
+
+private:
+    MeshOrientationWorkspace (const MeshOrientationWorkspace&);
+    void operator = (const MeshOrientationWorkspace&);
+
+    /** Scratch memory of one batch of components of the parallel region growing. */
+    struct Batch
+    {
+        std::vector<FacetIndex> result;
+        std::vector<FacetIndex> wrong;
+        std::vector<FacetIndex> complement;
+    };
+
+    FlagBitmap _visited; /**< Replaces the VISIT flag. */
+    FlagBitmap _wrong;   /**< Replaces the TMP0 flag. */
+    std::vector<FacetIndex> _aulIndices;    /**< Result of HarmonizeNormals(). */
+    std::vector<FacetIndex> _aulComplement; /**< Correct facets of a component. */
+    std::vector<FacetIndex> _aulFalsePos;   /**< Corrected false positives. */
+    std::vector<FacetIndex> _aulOthers;     /**< Other facets of a corrected region. */
+    std::vector<FacetIndex> _aulBorder;     /**< Heap of facets with a false positive neighbour. */
+    std::vector<FacetIndex> _aulCurrent;    /**< Ring buffers of the traversal. */
+    std::vector<FacetIndex> _aulNext;
+    std::vector<FacetIndex> _aulSeeds;      /**< Start facets of the components. */
+    std::vector<Batch> _aclBatches;
+    std::unique_ptr<std::atomic<FacetIndex>[]> _aClaims; /**< Claims of the parallel traversal. */
+    std::size_t _ulClaims;
+
+    friend class MeshEvalOrientation;
+    friend class MeshOrientationPlan;
+    friend class MeshTopoAlgorithm;
 };
 
 /**
  * The MeshEvalOrientation class checks the mesh kernel for consistent facet normals.
+ * The visited and false oriented facets are kept in bitmaps of a workspace,
+ * so the flags of the facets are not touched and several instances can evaluate
+ * the same kernel concurrently.
+ * The result is kept in the topology cache of the kernel, so that evaluating the
+ * kernel again before its facets are modified skips the traversal.
  * @author Werner Mayer
  */
 class MeshExport MeshEvalOrientation : public MeshEvaluation
@@ -105,10 +225,168 @@ class MeshExport MeshEvalOrientation : public MeshEvaluation
 public:
     MeshEvalOrientation (const MeshKernel& rclM);
     ~MeshEvalOrientation();
-    std::vector<unsigned long> GetIndices() const;
+    std::vector<FacetIndex> GetIndices() const;
+    /**
+     * Collects the false oriented facets in \a uIndices like GetIndices(). The memory
+     * of \a uIndices is reused.
+     */
+    void GetIndices(std::vector<FacetIndex>& uIndices) const;
+    /**
+     * If a thread pool is set the topologic independent components are harmonized
+     * concurrently. The result is exactly the same as with the serial algorithm.
+     */
+    void SetThreadPool(ThreadPool* pool)
+    { _pool = pool; }
+    /** Records the phases and counters in \a trace if built with MESH_TRACE. */
+    void SetTrace(MeshTrace* trace)
+    { _trace = trace; }
+    /**
+     * Uses the scratch memory of \a workspace instead of the memory of this instance.
+     * By default, i.e. if \a workspace is null, the memory is released with this instance.
+     */
+    void SetWorkspace(MeshOrientationWorkspace* workspace)
+    { _workspace = workspace; }
+    /** Returns the number of topologic independent components found by the last GetIndices(). */
+    unsigned long CountComponents() const
+    { return _ulComponents; }
+
+private:
+    MeshOrientationWorkspace& Workspace() const
+    { return _workspace ? *_workspace : _ownWorkspace; }
+    void CollectIndices(std::vector<FacetIndex>&) const;
+    bool CollectIndicesParallel(std::vector<FacetIndex>&, MeshTopologyCache&) const;
+    FacetIndex HasFalsePositives(const std::vector<FacetIndex>&) const;
+    FacetIndex FalsePositiveNeighbour(FacetIndex) const;
+    void CorrectFalsePositives(std::vector<FacetIndex>&, FacetIndex) const;
+
+private:
+    ThreadPool* _pool;
+    MeshTrace* _trace;
+    MeshOrientationWorkspace* _workspace;
+    mutable MeshOrientationWorkspace _ownWorkspace;
+    mutable unsigned long _ulComponents;
+};
+
+/**
+ * The MeshOrientationPlan class finds the facets MeshTopoAlgorithm::HarmonizeNormals()
+ * would flip without modifying the kernel. The flip set can be written compactly into
+ * memory of the caller, either as bitmap or as ranges of consecutive facet indices.
+ */
+class MeshExport MeshOrientationPlan
+{
+public:
+    /** Summary of the changes. */
+    struct Summary
+    {
+        unsigned long countFacets;     /**< Facets of the mesh. */
+        unsigned long countComponents; /**< Topologic independent components. */
+        unsigned long countFlipped;    /**< Facets to flip. */
+        unsigned long countRanges;     /**< Ranges of consecutive facets to flip. */
+    };
+
+    MeshOrientationPlan (const MeshKernel& rclM);
+    ~MeshOrientationPlan ();
+
+    /** Runs the analysis concurrently on \a pool, see MeshEvalOrientation. */
+    void SetThreadPool (ThreadPool* pool)
+    { _pool = pool; }
+    /** Records the phases and counters in \a trace if built with MESH_TRACE. */
+    void SetTrace (MeshTrace* trace)
+    { _trace = trace; }
+    /**
+     * Uses the scratch memory of \a workspace. The flip set is kept in the workspace,
+     * so it is only valid until the workspace is used again.
+     */
+    void SetWorkspace (MeshOrientationWorkspace* workspace)
+    { _workspace = workspace; }
+
+    /** Finds the facets to flip. */
+    void Compute (void);
+    const Summary& GetSummary (void) const
+    { return _clSummary; }
+    /** Returns the facets to flip in ascending order. */
+    const std::vector<FacetIndex>& GetIndices (void) const
+    { return Workspace()._aulIndices; }
+
+    /** Returns the number of words of the bitmap written by WriteBitmap(). */
+    std::size_t CountBitmapWords (void) const
+    { return (_clSummary.countFacets + 63) / 64; }
+    /**
+     * Writes the flip set as bitmap to \a pWords where bit i % 64 of word i / 64 is
+     * set if facet i is to flip. Writes at most \a ulWords words and returns the
+     * number of words of the complete bitmap.
+     */
+    std::size_t WriteBitmap (uint64_t* pWords, std::size_t ulWords) const;
+    /**
+     * Writes the flip set as ranges to \a pRanges, range k from facet pRanges[2k] up
+     * to facet pRanges[2k+1] exclusively. Writes at most \a ulRanges ranges and
+     * returns the number of all ranges.
+     */
+    template <class TIndex>
+    std::size_t WriteRanges (TIndex* pRanges, std::size_t ulRanges) const
+    {
+        const std::vector<FacetIndex>& indices = GetIndices();
+        std::size_t ulRange = 0;
+        for (std::size_t i = 0; i < indices.size() && ulRange < ulRanges; ulRange++) {
+            std::size_t j = i + 1;
+            while (j < indices.size() && indices[j] == indices[j - 1] + 1)
+                j++;
+            pRanges[2 * ulRange] = static_cast<TIndex>(indices[i]);
+            pRanges[2 * ulRange + 1] = static_cast<TIndex>(indices[j - 1] + 1);
+            i = j;
+        }
+        return _clSummary.countRanges;
+    }
+
+private:
+    MeshOrientationWorkspace& Workspace() const
+    { return _workspace ? *_workspace : _ownWorkspace; }
+
+    MeshOrientationPlan (const MeshOrientationPlan&);
+    void operator = (const MeshOrientationPlan&);
+
+    const MeshKernel& _rclMesh;
+    ThreadPool* _pool;
+    MeshTrace* _trace;
+    MeshOrientationWorkspace* _workspace;
+    mutable MeshOrientationWorkspace _ownWorkspace;
+    Summary _clSummary;
+};
+
+/**
+ * The MeshEvalOrientationParity class finds the false oriented facets without region
+ * growing. Each link between neighbour facets is a constraint that both facets are
+ * oriented the same way or the opposite way. All constraints are solved in one
+ * parallel sweep by a lock-free union-find that keeps the parity of each facet
+ * relative to the root of its component, the facet with the lowest index.
+ * Afterwards each component is decided by the same 40% rule as in MeshEvalOrientation.
+ * Thus for orientable components both classes find the same facets.
+ * If the constraints of a component contradict each other, i.e. it is not
+ * orientable, or a facet references a neighbour that does not reference it back,
+ * the result of the region growing depends on the traversal order. Then GetIndices()
+ * fails and MeshEvalOrientation has to be used.
+ */
+class MeshExport MeshEvalOrientationParity : public MeshEvaluation
+{
+public:
+    MeshEvalOrientationParity (const MeshKernel& rclM);
+    ~MeshEvalOrientationParity();
+    /**
+     * Collects the false oriented facets in ascending order in \a uIndices.
+     * Returns false and an empty \a uIndices if the orientation cannot be solved
+     * by constraints.
+     */
+    bool GetIndices(std::vector<FacetIndex>& uIndices) const;
+    /** Solves the constraints and decides the components concurrently on \a pool. */
+    void SetThreadPool(ThreadPool* pool)
+    { _pool = pool; }
+    /** Records the phases and counters in \a trace if built with MESH_TRACE. */
+    void SetTrace(MeshTrace* trace)
+    { _trace = trace; }
 
 private:
-    unsigned long HasFalsePositives(const std::vector<unsigned long>&) const;
+    ThreadPool* _pool;
+    MeshTrace* _trace;
 };
 
 
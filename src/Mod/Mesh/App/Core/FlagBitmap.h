@@ -0,0 +1,159 @@
+/***************************************************************************
+ *   Copyright (c) 2026 The mesh-repair contributors                       *
+ *                                                                         *
+ *   This file is part of mesh-repair, which is based on FreeCAD.          *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef MESH_FLAGBITMAP_H
+#define MESH_FLAGBITMAP_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "Elements.h"
+
+namespace MeshCore {
+
+/**
+ * The FlagBitmap class stores one mark per element in a packed bit array.
+ * It replaces the status flags of MeshFacet for algorithms that must not modify
+ * the mesh kernel, so that several of them can analyse the same kernel at once.
+ * Single bits can be set and tested from several threads concurrently with the
+ * atomic methods.
+ */
+class FlagBitmap
+{
+public:
+    typedef uint64_t Word;
+    enum { WordBits = 64 };
+
+    FlagBitmap (void) : _ulSize(0), _ulWords(0), _ulCapacity(0) { }
+    explicit FlagBitmap (std::size_t ulSize) : _ulSize(0), _ulWords(0), _ulCapacity(0)
+    { Resize(ulSize); }
+
+    /** Returns the number of elements. */
+    std::size_t Size (void) const
+    { return _ulSize; }
+    /** Returns the number of words of the bit array. */
+    std::size_t CountWords (void) const
+    { return _ulWords; }
+    /**
+     * Sets the number of elements to \a ulSize and resets all bits. Memory is only
+     * re-allocated if the current capacity is too small.
+     */
+    void Resize (std::size_t ulSize)
+    {
+        std::size_t ulWords = (ulSize + WordBits - 1) / WordBits;
+        if (ulWords > _ulCapacity) {
+            _aWords.reset(new std::atomic<Word>[ulWords]);
+            _ulCapacity = ulWords;
+        }
+        _ulSize = ulSize;
+        _ulWords = ulWords;
+        Clear();
+    }
+    /** Releases the memory, afterwards the bitmap has no elements. */
+    void Release (void)
+    {
+        _aWords.reset();
+        _ulSize = _ulWords = _ulCapacity = 0;
+    }
+    /** Resets all bits. */
+    void Clear (void)
+    {
+        for (std::size_t i = 0; i < _ulWords; i++)
+            _aWords[i].store(0, std::memory_order_relaxed);
+    }
+
+    bool Test (ElementIndex ulIndex) const
+    { return (_aWords[ulIndex / WordBits].load(std::memory_order_relaxed) & Mask(ulIndex)) != 0; }
+    /**
+     * Set(), Reset() and TestAndSet() are plain read-modify-writes for the single
+     * owner of the bitmap. Threads that share a bitmap must use SetAtomic() and
+     * TestAndSetAtomic() instead, even for different bits of the same word.
+     */
+    void Set (ElementIndex ulIndex)
+    { Store(ulIndex, Load(ulIndex) | Mask(ulIndex)); }
+    void Reset (ElementIndex ulIndex)
+    { Store(ulIndex, Load(ulIndex) & ~Mask(ulIndex)); }
+    /** Sets the bit and returns its previous state. */
+    bool TestAndSet (ElementIndex ulIndex)
+    {
+        Word ulBits = Load(ulIndex);
+        Store(ulIndex, ulBits | Mask(ulIndex));
+        return (ulBits & Mask(ulIndex)) != 0;
+    }
+    void SetAtomic (ElementIndex ulIndex)
+    { _aWords[ulIndex / WordBits].fetch_or(Mask(ulIndex), std::memory_order_relaxed); }
+    /**
+     * Sets the bit and returns its previous state. If several threads try to set
+     * the same bit exactly one of them gets false.
+     */
+    bool TestAndSetAtomic (ElementIndex ulIndex)
+    { return (_aWords[ulIndex / WordBits].fetch_or(Mask(ulIndex), std::memory_order_relaxed) & Mask(ulIndex)) != 0; }
+
+    /**
+     * Returns the index of the first element at or after \a ulFrom whose bit is
+     * not set, or Size() if there is none.
+     */
+    std::size_t FindFirstReset (std::size_t ulFrom) const
+    {
+        const Word full = ~Word(0);
+        while (ulFrom < _ulSize) {
+            Word ulBits = GetWord(ulFrom / WordBits);
+            if ((ulFrom % WordBits) == 0 && ulBits == full) {
+                ulFrom += WordBits; // skip a completely marked word at once
+                continue;
+            }
+            if ((ulBits & (Word(1) << (ulFrom % WordBits))) == 0)
+                return ulFrom;
+            ulFrom++;
+        }
+        return _ulSize;
+    }
+
+    /** Direct access to the words, e.g. for scanning for set bits. */
+    Word GetWord (std::size_t ulWord) const
+    { return _aWords[ulWord].load(std::memory_order_relaxed); }
+    void SetWord (std::size_t ulWord, Word ulBits)
+    { _aWords[ulWord].store(ulBits, std::memory_order_relaxed); }
+
+private:
+    static Word Mask (ElementIndex ulIndex)
+    { return Word(1) << (ulIndex % WordBits); }
+    Word Load (ElementIndex ulIndex) const
+    { return _aWords[ulIndex / WordBits].load(std::memory_order_relaxed); }
+    void Store (ElementIndex ulIndex, Word ulBits)
+    { _aWords[ulIndex / WordBits].store(ulBits, std::memory_order_relaxed); }
+
+    FlagBitmap (const FlagBitmap&);
+    void operator = (const FlagBitmap&);
+
+    std::unique_ptr<std::atomic<Word>[]> _aWords;
+    std::size_t _ulSize;
+    std::size_t _ulWords;
+    std::size_t _ulCapacity;
+};
+
+} // namespace MeshCore
+
+#endif // MESH_FLAGBITMAP_H
@@ -25,9 +25,15 @@
 
 #ifndef _PreComp_
 # include <algorithm>
+# include <cstring>
+# include <limits>
+# include <memory>
+# include <mutex>
 # include <stdexcept>
 # include <map>
 # include <queue>
+# include <utility>
+# include <vector>
 #endif
 
 #include <Base/Exception.h>
@@ -35,6 +41,7 @@
 #include <Base/Stream.h>
 #include <Base/Swap.h>
 
+#include "Adjacency.h"
 #include "Algorithm.h"
 #include "Approximation.h"
 #include "Helpers.h"
@@ -44,343 +51,1017 @@
 #include "Builder.h"
 #include "Smoothing.h"
 #include "MeshIO.h"
+#include "Storage.h"
+#include "ThreadPool.h"
 
 using namespace MeshCore;
 
 MeshKernel::MeshKernel (void)
-: _bValid(true)
+: _bBoxDirty(false), _bValid(true), _ulGeneration(0), _ulTopologyGeneration(0)
 {
     _clBoundBox.SetVoid();
 }
 
 MeshKernel::MeshKernel (const MeshKernel &rclMesh)
+: _bBoxDirty(false), _bValid(true), _ulGeneration(0), _ulTopologyGeneration(0)
 {
     *this = rclMesh;    
 }
 
-void MeshKernel::Clear (void)
+MeshKernel::MeshKernel (MeshKernel &&rclMesh) noexcept
+: _bBoxDirty(false), _bValid(true), _ulGeneration(0), _ulTopologyGeneration(0)
 {
-    _aclPointArray.clear();
-    _aclFacetArray.clear();
+    _clBoundBox.SetVoid();
+    Swap(rclMesh);
+}
 
-    // release memory
-    MeshPointArray().swap(_aclPointArray);
-    MeshFacetArray().swap(_aclFacetArray);
+MeshKernel& MeshKernel::operator = (MeshKernel &&rclMesh) noexcept
+{
+    if (this != &rclMesh) {
+        MeshKernel clMesh(std::move(rclMesh));
+        Swap(clMesh);
+    }
+    return *this;
+}
+
+void MeshKernel::Clear (void)
+{
+    // release memory, unless a copy still uses it
+    _clPoints.Clear();
+    _clFacets.Clear();
 
     _clBoundBox.SetVoid();
+    _bBoxDirty = true;
+    _ulGeneration++;
+    _ulTopologyGeneration++;
+    _clTopologyCache.Clear();
+}
+
+
+void MeshKernel::AssignArrays (MeshPointArray& rPoints, MeshFacetArray& rFacets)
+{
+    MeshSharedArray<MeshPointArray> clPoints(rPoints);
+    MeshSharedArray<MeshFacetArray> clFacets(rFacets);
+    _clPoints.Swap(clPoints);
+    _clFacets.Swap(clFacets);
+    clPoints.MoveTo(rPoints);
+    clFacets.MoveTo(rFacets);
+}
+
+void MeshKernel::Adopt (MeshPointArray& rPoints, MeshFacetArray& rFacets, bool checkNeighbourHood)
+{
+    AssignArrays(rPoints, rFacets);
+
+    if (checkNeighbourHood)
+        RebuildNeighbours();
+    _bBoxDirty = true;
+    _ulGeneration++;
+    _ulTopologyGeneration++;
+}
+
+void MeshKernel::Adopt (MeshPointArray&& rPoints, MeshFacetArray&& rFacets, bool checkNeighbourHood)
+{
+    MeshPointArray clPoints(std::move(rPoints));
+    MeshFacetArray clFacets(std::move(rFacets));
+    Adopt(clPoints, clFacets, checkNeighbourHood);
+}
+
+void MeshKernel::Swap (MeshKernel& rclMesh)
+{
+    _clPoints.Swap(rclMesh._clPoints);
+    _clFacets.Swap(rclMesh._clFacets);
+    std::swap(_clBoundBox, rclMesh._clBoundBox);
+    bool bBoxDirty = _bBoxDirty;
+    _bBoxDirty = rclMesh._bBoxDirty.load();
+    rclMesh._bBoxDirty = bBoxDirty;
+    std::swap(_bValid, rclMesh._bValid);
+    // the cached analyses stay with their generation
+    std::swap(_ulGeneration, rclMesh._ulGeneration);
+    std::swap(_ulTopologyGeneration, rclMesh._ulTopologyGeneration);
+    _clTopologyCache.Swap(rclMesh._clTopologyCache);
+}
+
+unsigned long MeshKernel::RebuildNeighbours (ThreadPool* pool)
+{
+    _ulGeneration++;
+    _ulTopologyGeneration++;
+    MeshAdjacencyBuilder builder(_clFacets.Detach());
+    builder.SetThreadPool(pool);
+    return builder.Build();
+}
+
+namespace {
+
+/**
+ * Computes the bounding box of \a rclPoints chunk by chunk in parallel. The loop
+ * over a chunk keeps the six extremes in separate variables and uses plain
+ * comparisons, so that the compiler can vectorize it.
+ */
+Base::BoundBox3f PointBoundBox (ThreadPool* pool, const MeshPointArray& rclPoints)
+{
+    const std::size_t ulCount = rclPoints.size();
+    const std::size_t ulGrain = GrainSize(pool, ulCount, 16384);
+    const std::size_t ulChunks = (ulCount + ulGrain - 1) / ulGrain;
+    std::vector<Base::BoundBox3f> aclBoxes(ulChunks);
+
+    ParallelFor(pool, 0, ulChunks, 1, [&](std::size_t b, std::size_t e) {
+        for (std::size_t c = b; c < e; c++) {
+            const MeshPoint* pPoint = rclPoints.data() + c * ulGrain;
+            const MeshPoint* pEnd = rclPoints.data() + std::min(ulCount, (c + 1) * ulGrain);
+            float fMinX = pPoint->x, fMinY = pPoint->y, fMinZ = pPoint->z;
+            float fMaxX = fMinX, fMaxY = fMinY, fMaxZ = fMinZ;
+            for (; pPoint != pEnd; ++pPoint) {
+                const float x = pPoint->x, y = pPoint->y, z = pPoint->z;
+                fMinX = x < fMinX ? x : fMinX;
+                fMinY = y < fMinY ? y : fMinY;
+                fMinZ = z < fMinZ ? z : fMinZ;
+                fMaxX = x > fMaxX ? x : fMaxX;
+                fMaxY = y > fMaxY ? y : fMaxY;
+                fMaxZ = z > fMaxZ ? z : fMaxZ;
+            }
+            aclBoxes[c] = Base::BoundBox3f(fMinX, fMinY, fMinZ, fMaxX, fMaxY, fMaxZ);
+        }
+    });
+
+    Base::BoundBox3f clBox;
+    clBox.SetVoid();
+    for (std::vector<Base::BoundBox3f>::const_iterator it = aclBoxes.begin(); it != aclBoxes.end(); ++it)
+        clBox.Add(*it);
+    return clBox;
+}
+
+}
+
+void MeshKernel::RecalcBoundBox (ThreadPool* pool)
+{
+    _clBoundBox = PointBoundBox(pool, _clPoints.Get());
+    _bBoxDirty = false;
+}
+
+const Base::BoundBox3f& MeshKernel::GetBoundBox (ThreadPool* pool) const
+{
+    // the box is only written under the lock and published by clearing the flag
+    if (_bBoxDirty.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(_clBoxMutex);
+        if (_bBoxDirty.load(std::memory_order_relaxed)) {
+            _clBoundBox = PointBoundBox(pool, _clPoints.Get());
+            _bBoxDirty.store(false, std::memory_order_release);
+        }
+    }
+    return _clBoundBox;
 }
 
+namespace {
 
-void MeshKernel::RemoveInvalids ()
+/**
+ * Splits an element array into chunks and numbers its valid elements. Afterwards
+ * \a rulRemap holds the new index of each valid element, and \a rulChunkBegin the
+ * new index of the first valid element of each chunk, followed by the number of
+ * valid elements. An invalid element gets ELEMENT_INDEX_MAX, or if \a bShiftInvalid
+ * is set the new index of the next valid element.
+ */
+template <class TArray>
+void BuildRemapTable (ThreadPool* pool, const TArray& rclArray, std::size_t ulGrain, bool bShiftInvalid,
+                      std::vector<ElementIndex>& rulRemap, std::vector<std::size_t>& rulChunkBegin)
 {
-    std::vector<unsigned long> aulDecrements;
-    std::vector<unsigned long>::iterator pDIter;
-    unsigned long ulDec, i, k;
-    MeshPointArray::_TIterator pPIter, pPEnd;
-    MeshFacetArray::_TIterator pFIter, pFEnd;
+    const std::size_t ulCount = rclArray.size();
+    const std::size_t ulChunks = (ulCount + ulGrain - 1) / ulGrain;
+
+    rulRemap.resize(ulCount);
+    rulChunkBegin.assign(ulChunks + 1, 0);
+
+    // count the valid elements of each chunk
+    ParallelFor(pool, 0, ulChunks, 1, [&](std::size_t b, std::size_t e) {
+        for (std::size_t c = b; c < e; c++) {
+            std::size_t ulEnd = std::min(ulCount, (c + 1) * ulGrain);
+            std::size_t ulValid = 0;
+            for (std::size_t i = c * ulGrain; i < ulEnd; i++) {
+                if (rclArray[i].IsValid())
+                    ulValid++;
+            }
+            rulChunkBegin[c + 1] = ulValid;
+        }
+    });
+
+    // exclusive prefix sum over the chunks
+    for (std::size_t c = 0; c < ulChunks; c++)
+        rulChunkBegin[c + 1] += rulChunkBegin[c];
+
+    // number the valid elements of each chunk
+    ParallelFor(pool, 0, ulChunks, 1, [&](std::size_t b, std::size_t e) {
+        for (std::size_t c = b; c < e; c++) {
+            std::size_t ulEnd = std::min(ulCount, (c + 1) * ulGrain);
+            ElementIndex ulNext = static_cast<ElementIndex>(rulChunkBegin[c]);
+            for (std::size_t i = c * ulGrain; i < ulEnd; i++)
+                rulRemap[i] = rclArray[i].IsValid() ? ulNext++ : (bShiftInvalid ? ulNext : ELEMENT_INDEX_MAX);
+        }
+    });
+}
+
+/**
+ * Moves the valid elements of \a rclArray to the positions numbered by BuildRemapTable()
+ * without a second array. Each chunk is first compacted to its own start in parallel,
+ * then the compacted blocks are moved down in ascending order, which never overwrites
+ * a block that has not been moved yet.
+ */
+template <class TArray>
+void CompactInPlace (ThreadPool* pool, TArray& rclArray, std::size_t ulGrain,
+                     const std::vector<std::size_t>& rulChunkBegin)
+{
+    const std::size_t ulCount = rclArray.size();
+    const std::size_t ulChunks = rulChunkBegin.size() - 1;
+
+    ParallelFor(pool, 0, ulChunks, 1, [&](std::size_t b, std::size_t e) {
+        for (std::size_t c = b; c < e; c++) {
+            std::size_t ulBegin = c * ulGrain;
+            std::size_t ulEnd = std::min(ulCount, ulBegin + ulGrain);
+            std::size_t ulPos = ulBegin;
+            for (std::size_t i = ulBegin; i < ulEnd; i++) {
+                if (rclArray[i].IsValid()) {
+                    if (ulPos != i)
+                        rclArray[ulPos] = rclArray[i];
+                    ulPos++;
+                }
+            }
+        }
+    });
 
-    // generate array of decrements
-    aulDecrements.resize(_aclPointArray.size());
-    pDIter = aulDecrements.begin();
-    ulDec  = 0;
-    pPEnd  = _aclPointArray.end();
-    for (pPIter = _aclPointArray.begin(); pPIter != pPEnd; ++pPIter) {
-        *pDIter++ = ulDec;
-        if (pPIter->IsValid() == false)
-            ulDec++;
+    for (std::size_t c = 1; c < ulChunks; c++) {
+        std::size_t ulSource = c * ulGrain;
+        std::size_t ulTarget = rulChunkBegin[c];
+        std::size_t ulValid = rulChunkBegin[c + 1] - rulChunkBegin[c];
+        if (ulSource != ulTarget && ulValid > 0)
+            std::move(rclArray.begin() + ulSource, rclArray.begin() + ulSource + ulValid,
+                      rclArray.begin() + ulTarget);
     }
 
+    rclArray.resize(rulChunkBegin[ulChunks]);
+}
+
+}
+
+void MeshKernel::RemoveInvalids (ThreadPool* pool)
+{
+    std::vector<ElementIndex> aulRemap;
+    std::vector<std::size_t> aulChunkBegin;
+    // arrays shared with a copy are copied first
+    MeshPointArray& rPoints = _clPoints.Detach();
+    MeshFacetArray& rFacets = _clFacets.Detach();
+    _ulGeneration++;
+    _ulTopologyGeneration++;
+
+    // number the valid points, a removed point is replaced by the next valid one
+    std::size_t ulGrain = GrainSize(pool, rPoints.size(), 4096);
+    BuildRemapTable(pool, rPoints, ulGrain, true, aulRemap, aulChunkBegin);
+
     // correct point indices of the facets
-    pFEnd  = _aclFacetArray.end();
-    for (pFIter = _aclFacetArray.begin(); pFIter != pFEnd; ++pFIter) {
-        if (pFIter->IsValid() == true) {
-            pFIter->_aulPoints[0] -= aulDecrements[pFIter->_aulPoints[0]];
-            pFIter->_aulPoints[1] -= aulDecrements[pFIter->_aulPoints[1]];
-            pFIter->_aulPoints[2] -= aulDecrements[pFIter->_aulPoints[2]];
+    ParallelFor(pool, 0, rFacets.size(), GrainSize(pool, rFacets.size(), 4096),
+                [&](std::size_t b, std::size_t e) {
+        for (std::size_t i = b; i < e; i++) {
+            MeshFacet& rFacet = rFacets[i];
+            if (rFacet.IsValid()) {
+                for (int j = 0; j < 3; j++) {
+                    if (rFacet._aulPoints[j] < aulRemap.size())
+                        rFacet._aulPoints[j] = aulRemap[rFacet._aulPoints[j]];
+                }
+            }
+        }
+    });
+
+    // delete points, the bounding box may shrink
+    if (aulChunkBegin.back() != rPoints.size())
+        _bBoxDirty = true;
+    CompactInPlace(pool, rPoints, ulGrain, aulChunkBegin);
+
+    // number the valid facets, the table of the points is no longer needed
+    ulGrain = GrainSize(pool, rFacets.size(), 4096);
+    BuildRemapTable(pool, rFacets, ulGrain, false, aulRemap, aulChunkBegin);
+
+    // correct neighbour indices of the facets, invalid neighbours become open edges
+    ParallelFor(pool, 0, rFacets.size(), ulGrain, [&](std::size_t b, std::size_t e) {
+        for (std::size_t i = b; i < e; i++) {
+            MeshFacet& rFacet = rFacets[i];
+            if (rFacet.IsValid()) {
+                for (int j = 0; j < 3; j++) {
+                    FacetIndex k = rFacet._aulNeighbours[j];
+                    if (k < aulRemap.size())
+                        rFacet._aulNeighbours[j] = aulRemap[k];
+                }
+            }
         }
+    });
+
+    // delete facets
+    CompactInPlace(pool, rFacets, ulGrain, aulChunkBegin);
+}
+
+void MeshKernel::Permute (const std::vector<PointIndex>& rulPointOrder, const std::vector<FacetIndex>& rulFacetOrder,
+                          ThreadPool* pool)
+{
+    const MeshPointArray& rPoints = _clPoints.Get();
+    const MeshFacetArray& rFacets = _clFacets.Get();
+    const std::size_t ulCtPts = rPoints.size();
+    const std::size_t ulCtFts = rFacets.size();
+    assert(rulPointOrder.size() == ulCtPts && rulFacetOrder.size() == ulCtFts);
+
+    // new index of each point and facet
+    std::vector<PointIndex> aulNewPoint(ulCtPts);
+    std::vector<FacetIndex> aulNewFacet(ulCtFts);
+    for (std::size_t i = 0; i < ulCtPts; i++)
+        aulNewPoint[rulPointOrder[i]] = static_cast<PointIndex>(i);
+    for (std::size_t i = 0; i < ulCtFts; i++)
+        aulNewFacet[rulFacetOrder[i]] = static_cast<FacetIndex>(i);
+
+    MeshPointArray aclPoints(static_cast<PointIndex>(ulCtPts));
+    ParallelFor(pool, 0, ulCtPts, GrainSize(pool, ulCtPts, 4096), [&](std::size_t b, std::size_t e) {
+        for (std::size_t i = b; i < e; i++)
+            aclPoints[i] = rPoints[rulPointOrder[i]];
+    });
+
+    MeshFacetArray aclFacets(static_cast<FacetIndex>(ulCtFts));
+    ParallelFor(pool, 0, ulCtFts, GrainSize(pool, ulCtFts, 4096), [&](std::size_t b, std::size_t e) {
+        for (std::size_t i = b; i < e; i++) {
+            MeshFacet& rFacet = aclFacets[i];
+            rFacet = rFacets[rulFacetOrder[i]];
+            for (int j = 0; j < 3; j++) {
+                if (rFacet._aulPoints[j] < ulCtPts)
+                    rFacet._aulPoints[j] = aulNewPoint[rFacet._aulPoints[j]];
+                if (rFacet._aulNeighbours[j] < ulCtFts)
+                    rFacet._aulNeighbours[j] = aulNewFacet[rFacet._aulNeighbours[j]];
+            }
+        }
+    });
+
+    AssignArrays(aclPoints, aclFacets);
+    _ulGeneration++;
+    _ulTopologyGeneration++;
+}
+
+MeshFacetArray MeshKernel::GetFacets(const std::vector<FacetIndex>& indices) const
+{
+    MeshFacetArray ary;
+    ary.reserve(indices.size());
+    const MeshFacetArray& rFacets = _clFacets.Get();
+    for (std::vector<FacetIndex>::const_iterator it = indices.begin(); it != indices.end(); ++it)
+        ary.push_back(rFacets[*it]);
+    return ary;
+}
+
+
+
+namespace {
+
+// Binary mesh image, version 2
+//
+// The header is followed by the point and the facet records at offsets aligned
+// to MeshImageAlignment. The records are verbatim copies of MeshPoint and MeshFacet
+// of the writing machine, the header describes their layout and the byte order.
+// Thus a reader with the same layout can map the records and use them in place,
+// any other reader converts them field by field.
+const uint32_t MeshImageMagic     = 0xA0B0C0D0;
+const uint32_t MeshImageVersion   = 0x020000;
+const uint32_t MeshImageByteOrder = 0x01020304;
+const uint64_t MeshImageAlignment = 4096;
+
+struct MeshImageHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t headerSize;
+    uint32_t pointSize;             // size of a point record
+    uint32_t pointCoordOffset;      // offset of x, followed by y and z as float
+    uint32_t pointFlagOffset;
+    uint32_t facetSize;             // size of a facet record
+    uint32_t indexSize;             // size of a point or facet index, 4 or 8
+    uint32_t facetPointsOffset;
+    uint32_t facetNeighboursOffset;
+    uint32_t facetFlagOffset;
+    uint64_t countPoints;
+    uint64_t countFacets;
+    uint64_t pointsOffset;          // offsets from the start of the image
+    uint64_t facetsOffset;
+    float    boundBox[6];           // MinX, MinY, MinZ, MaxX, MaxY, MaxZ
+    uint32_t reserved[2];
+};
+
+bool IsLittleEndian (void)
+{
+    const uint32_t value = 1;
+    unsigned char byte;
+    std::memcpy(&byte, &value, 1);
+    return byte == 1;
+}
+
+uint64_t AlignImageOffset (uint64_t ulOffset)
+{
+    return (ulOffset + MeshImageAlignment - 1) / MeshImageAlignment * MeshImageAlignment;
+}
+
+void InitImageHeader (MeshImageHeader& header, uint64_t ulCtPts, uint64_t ulCtFts,
+                      const Base::BoundBox3f& box)
+{
+    MeshPoint point;
+    MeshFacet facet;
+    const char* pPt = reinterpret_cast<const char*>(&point);
+    const char* pFt = reinterpret_cast<const char*>(&facet);
+
+    std::memset(&header, 0, sizeof(header));
+    header.magic = MeshImageMagic;
+    header.version = MeshImageVersion;
+    header.byteOrder = MeshImageByteOrder;
+    header.headerSize = sizeof(MeshImageHeader);
+    header.pointSize = sizeof(MeshPoint);
+    header.pointCoordOffset = static_cast<uint32_t>(reinterpret_cast<const char*>(&point.x) - pPt);
+    header.pointFlagOffset = static_cast<uint32_t>(reinterpret_cast<const char*>(&point._ucFlag) - pPt);
+    header.facetSize = sizeof(MeshFacet);
+    header.indexSize = sizeof(ElementIndex);
+    header.facetPointsOffset = static_cast<uint32_t>(reinterpret_cast<const char*>(facet._aulPoints) - pFt);
+    header.facetNeighboursOffset = static_cast<uint32_t>(reinterpret_cast<const char*>(facet._aulNeighbours) - pFt);
+    header.facetFlagOffset = static_cast<uint32_t>(reinterpret_cast<const char*>(&facet._ucFlag) - pFt);
+    header.countPoints = ulCtPts;
+    header.countFacets = ulCtFts;
+    header.pointsOffset = AlignImageOffset(sizeof(MeshImageHeader));
+    header.facetsOffset = AlignImageOffset(header.pointsOffset + ulCtPts * sizeof(MeshPoint));
+    header.boundBox[0] = box.MinX;
+    header.boundBox[1] = box.MinY;
+    header.boundBox[2] = box.MinZ;
+    header.boundBox[3] = box.MaxX;
+    header.boundBox[4] = box.MaxY;
+    header.boundBox[5] = box.MaxZ;
+}
+
+bool IsImageHeader (const MeshImageHeader& header)
+{
+    uint32_t magic = header.magic, version = header.version;
+    Base::SwapEndian(magic);
+    Base::SwapEndian(version);
+    return (header.magic == MeshImageMagic && header.version == MeshImageVersion) ||
+           (magic == MeshImageMagic && version == MeshImageVersion);
+}
+
+/**
+ * Brings the header into the byte order of this machine and checks that it
+ * describes a consistent image of \a ulSize bytes, where 0 means unknown size.
+ * Returns true if the records are stored in the other byte order.
+ */
+bool CheckImageHeader (MeshImageHeader& header, uint64_t ulSize)
+{
+    bool bSwap = header.byteOrder != MeshImageByteOrder;
+    if (bSwap) {
+        Base::SwapEndian(header.magic);
+        Base::SwapEndian(header.version);
+        Base::SwapEndian(header.byteOrder);
+        Base::SwapEndian(header.headerSize);
+        Base::SwapEndian(header.pointSize);
+        Base::SwapEndian(header.pointCoordOffset);
+        Base::SwapEndian(header.pointFlagOffset);
+        Base::SwapEndian(header.facetSize);
+        Base::SwapEndian(header.indexSize);
+        Base::SwapEndian(header.facetPointsOffset);
+        Base::SwapEndian(header.facetNeighboursOffset);
+        Base::SwapEndian(header.facetFlagOffset);
+        Base::SwapEndian(header.countPoints);
+        Base::SwapEndian(header.countFacets);
+        Base::SwapEndian(header.pointsOffset);
+        Base::SwapEndian(header.facetsOffset);
+        for (int i = 0; i < 6; i++)
+            Base::SwapEndian(header.boundBox[i]);
+        if (header.byteOrder != MeshImageByteOrder)
+            throw Base::BadFormatError("Invalid byte order of mesh image");
     }
 
-    // delete point, number of valid points
-    unsigned long ulNewPts = std::count_if(_aclPointArray.begin(), _aclPointArray.end(),
-                                           [](const MeshPoint& p) { return p.IsValid(); });
-    // tmp. point array
-    MeshPointArray  aclTempPt(ulNewPts);
-    MeshPointArray::_TIterator pPTemp = aclTempPt.begin();
-    pPEnd = _aclPointArray.end();
-    for (pPIter = _aclPointArray.begin(); pPIter != pPEnd; ++pPIter) {
-        if (pPIter->IsValid() == true)
-            *pPTemp++ = *pPIter;
+    if (header.magic != MeshImageMagic || header.version != MeshImageVersion)
+        throw Base::BadFormatError("Unsupported version of mesh image");
+
+    // record layout
+    if (header.headerSize < sizeof(MeshImageHeader) ||
+        (header.indexSize != 4 && header.indexSize != 8) ||
+        header.pointSize == 0 || header.facetSize == 0 ||
+        header.pointCoordOffset + 3 * sizeof(float) > header.pointSize ||
+        header.pointFlagOffset >= header.pointSize ||
+        header.facetPointsOffset + 3 * header.indexSize > header.facetSize ||
+        header.facetNeighboursOffset + 3 * header.indexSize > header.facetSize ||
+        header.facetFlagOffset >= header.facetSize)
+        throw Base::BadFormatError("Invalid record layout of mesh image");
+
+    // the mesh must be addressable with the indices of this build
+    if (header.countPoints >= POINT_INDEX_MAX || header.countFacets >= FACET_INDEX_MAX)
+        throw Base::BadFormatError("Mesh image is too big");
+
+    // extent of the data, safe against overflow
+    const uint64_t ulMax = std::numeric_limits<uint64_t>::max();
+    if (header.pointsOffset < header.headerSize ||
+        header.countPoints > (ulMax - header.pointsOffset) / header.pointSize ||
+        header.facetsOffset < header.pointsOffset + header.countPoints * header.pointSize ||
+        header.countFacets > (ulMax - header.facetsOffset) / header.facetSize)
+        throw Base::BadFormatError("Invalid data structure");
+    if (ulSize > 0 && header.facetsOffset + header.countFacets * header.facetSize > ulSize)
+        throw Base::BadFormatError("Mesh image is truncated");
+
+    return bSwap;
+}
+
+/** Returns true if the records can be used in place by this build. */
+bool IsNativeImage (const MeshImageHeader& header, bool bSwap)
+{
+    MeshImageHeader native;
+    InitImageHeader(native, 0, 0, Base::BoundBox3f());
+    return !bSwap &&
+           header.pointSize == native.pointSize &&
+           header.pointCoordOffset == native.pointCoordOffset &&
+           header.pointFlagOffset == native.pointFlagOffset &&
+           header.facetSize == native.facetSize &&
+           header.indexSize == native.indexSize &&
+           header.facetPointsOffset == native.facetPointsOffset &&
+           header.facetNeighboursOffset == native.facetNeighboursOffset &&
+           header.facetFlagOffset == native.facetFlagOffset;
+}
+
+template <class T>
+T DecodeValue (const char* pData, bool bSwap)
+{
+    T value;
+    std::memcpy(&value, pData, sizeof(T));
+    if (bSwap)
+        Base::SwapEndian(value);
+    return value;
+}
+
+/** Converts a stored index, an index with all bits set is mapped to \a ulMax. */
+template <class TIndex>
+TIndex DecodeIndex (const char* pData, uint32_t ulSize, bool bSwap, TIndex ulMax)
+{
+    uint64_t ulIndex;
+    if (ulSize == 4) {
+        uint32_t ulValue = DecodeValue<uint32_t>(pData, bSwap);
+        if (ulValue == std::numeric_limits<uint32_t>::max())
+            return ulMax;
+        ulIndex = ulValue;
     }
+    else {
+        ulIndex = DecodeValue<uint64_t>(pData, bSwap);
+        if (ulIndex == std::numeric_limits<uint64_t>::max())
+            return ulMax;
+    }
+
+    // an index that does not fit into this build cannot be valid
+    if (ulIndex >= static_cast<uint64_t>(ulMax))
+        throw Base::BadFormatError("Invalid data structure");
+    return static_cast<TIndex>(ulIndex);
+}
 
-    // free memory
-    //_aclPointArray = aclTempPt;
-    //aclTempPt.clear();
-    _aclPointArray.swap(aclTempPt);
-    MeshPointArray().swap(aclTempPt);
-
-    // generate array of facet decrements
-    aulDecrements.resize(_aclFacetArray.size());
-    pDIter = aulDecrements.begin();
-    ulDec  = 0;
-    pFEnd  = _aclFacetArray.end();
-    for (pFIter = _aclFacetArray.begin(); pFIter != pFEnd; ++pFIter, ++pDIter) {
-        *pDIter = ulDec;
-        if (pFIter->IsValid() == false)
-            ulDec++;
+void DecodePoints (const MeshImageHeader& header, bool bSwap, const char* pData,
+                   MeshPointArray::_TIterator it, std::size_t ulCount)
+{
+    for (std::size_t i = 0; i < ulCount; i++, ++it, pData += header.pointSize) {
+        const char* pCoord = pData + header.pointCoordOffset;
+        it->x = DecodeValue<float>(pCoord, bSwap);
+        it->y = DecodeValue<float>(pCoord + sizeof(float), bSwap);
+        it->z = DecodeValue<float>(pCoord + 2 * sizeof(float), bSwap);
+        it->_ucFlag = static_cast<unsigned char>(pData[header.pointFlagOffset]);
     }
+}
 
-    // correct neighbour indices of the facets
-    pFEnd = _aclFacetArray.end();
-    for (pFIter = _aclFacetArray.begin(); pFIter != pFEnd; ++pFIter) {
-        if (pFIter->IsValid() == true) {
-            for (i = 0; i < 3; i++) {
-                k = pFIter->_aulNeighbours[i];
-                if (k != ULONG_MAX) {
-                    if (_aclFacetArray[k].IsValid() == true)
-                        pFIter->_aulNeighbours[i] -= aulDecrements[k];
-                    else
-                        pFIter->_aulNeighbours[i] = ULONG_MAX;
-                }
+void DecodeFacets (const MeshImageHeader& header, bool bSwap, const char* pData,
+                   MeshFacetArray::_TIterator it, std::size_t ulCount)
+{
+    const uint32_t ulSize = header.indexSize;
+    for (std::size_t i = 0; i < ulCount; i++, ++it, pData += header.facetSize) {
+        const char* pPoints = pData + header.facetPointsOffset;
+        const char* pNeighbours = pData + header.facetNeighboursOffset;
+        for (int j = 0; j < 3; j++) {
+            it->_aulPoints[j] = DecodeIndex<PointIndex>(pPoints + j * ulSize, ulSize, bSwap, POINT_INDEX_MAX);
+            it->_aulNeighbours[j] = DecodeIndex<FacetIndex>(pNeighbours + j * ulSize, ulSize, bSwap, FACET_INDEX_MAX);
+        }
+        it->_ucFlag = static_cast<unsigned char>(pData[header.facetFlagOffset]);
+    }
+}
+
+/** Reads \a ulCount records of \a ulRecord bytes in blocks and converts them. */
+template <class TIterator, class TDecode>
+void ReadRecords (std::istream& rclIn, std::size_t ulRecord, TIterator it, std::size_t ulCount,
+                  TDecode decode)
+{
+    const std::size_t ulBlock = 65536;
+    std::vector<char> buffer(std::min(ulBlock, ulCount) * ulRecord);
+    while (ulCount > 0) {
+        std::size_t ulNum = std::min(ulBlock, ulCount);
+        if (!rclIn.read(buffer.data(), ulNum * ulRecord))
+            throw Base::BadFormatError("Reading from stream failed");
+        decode(buffer.data(), it, ulNum);
+        it += ulNum;
+        ulCount -= ulNum;
+    }
+}
+
+void SkipBytes (std::istream& rclIn, uint64_t ulBytes)
+{
+    char buffer[4096];
+    while (ulBytes > 0) {
+        std::streamsize ulNum = static_cast<std::streamsize>(std::min<uint64_t>(ulBytes, sizeof(buffer)));
+        if (!rclIn.read(buffer, ulNum))
+            throw Base::BadFormatError("Reading from stream failed");
+        ulBytes -= static_cast<uint64_t>(ulNum);
+    }
+}
+
+/** Checks that all point indices and neighbour indices are in range. */
+void ValidateIndices (const MeshPointArray& rPoints, const MeshFacetArray& rFacets)
+{
+    const PointIndex ulCtPts = static_cast<PointIndex>(rPoints.size());
+    const FacetIndex ulCtFts = static_cast<FacetIndex>(rFacets.size());
+    for (MeshFacetArray::_TConstIterator it = rFacets.begin(); it != rFacets.end(); ++it) {
+        for (int i = 0; i < 3; i++) {
+            if (it->_aulPoints[i] >= ulCtPts)
+                throw Base::BadFormatError("Invalid data structure");
+            if (it->_aulNeighbours[i] != FACET_INDEX_MAX && it->_aulNeighbours[i] >= ulCtFts)
+                throw Base::BadFormatError("Invalid data structure");
+        }
+    }
+}
+
+/** Lets \a rclArray use \a ulCount records at \a ulOffset of the mapped file in place. */
+template <class TArray>
+void AdoptMappedRecords (TArray& rclArray, const std::shared_ptr<MeshMappedFile>& file,
+                         uint64_t ulOffset, uint64_t ulCount)
+{
+    typedef typename TArray::value_type TElement;
+    std::shared_ptr<MeshStorageBlock> block = std::make_shared<MeshStorageBlock>
+        (file, file->Data() + ulOffset, static_cast<std::size_t>(ulCount) * sizeof(TElement));
+    block->adopting = true;
+    TArray(static_cast<typename TArray::size_type>(ulCount), MeshAllocator<TElement>(block)).swap(rclArray);
+    block->adopting = false;
+}
+
+/**
+ * Writes \a ulCount records through a zeroed staging buffer, so that the padding
+ * of the records is written as zeros instead of uninitialized memory. \a encode
+ * copies the members of one record to its slot in the buffer.
+ */
+template <class TElement, class TEncode>
+void WriteRecords (std::ostream& rclOut, const TElement* pRecords, std::size_t ulCount, TEncode encode)
+{
+    const std::size_t ulChunk = 4096;
+    std::vector<char> buffer(std::min(ulCount, ulChunk) * sizeof(TElement));
+    for (std::size_t i = 0; i < ulCount; i += ulChunk) {
+        const std::size_t n = std::min(ulChunk, ulCount - i);
+        std::memset(buffer.data(), 0, n * sizeof(TElement));
+        for (std::size_t k = 0; k < n; k++)
+            encode(pRecords[i + k], buffer.data() + k * sizeof(TElement));
+        rclOut.write(buffer.data(), static_cast<std::streamsize>(n * sizeof(TElement)));
+    }
+}
+
+void SetImageBoundBox (const MeshImageHeader& header, Base::BoundBox3f& box)
+{
+    box.MinX = header.boundBox[0];
+    box.MinY = header.boundBox[1];
+    box.MinZ = header.boundBox[2];
+    box.MaxX = header.boundBox[3];
+    box.MaxY = header.boundBox[4];
+    box.MaxZ = header.boundBox[5];
+}
+
+} // namespace
+
+void MeshKernel::Write (std::ostream &rclOut) const
+{
+    if (!rclOut || rclOut.bad())
+        return;
+
+    const MeshPointArray& rPoints = _clPoints.Get();
+    const MeshFacetArray& rFacets = _clFacets.Get();
+    MeshImageHeader header;
+    InitImageHeader(header, rPoints.size(), rFacets.size(), GetBoundBox());
+    const std::vector<char> padding(MeshImageAlignment, 0);
+
+    rclOut.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    rclOut.write(padding.data(), static_cast<std::streamsize>(header.pointsOffset - sizeof(header)));
+
+    // the records keep their in-memory layout, but only the members described by
+    // the header are written, all other bytes are zero
+    WriteRecords(rclOut, rPoints.data(), rPoints.size(),
+                 [&header](const MeshPoint& rPoint, char* pRecord) {
+        std::memcpy(pRecord + header.pointCoordOffset, &rPoint.x, 3 * sizeof(float));
+        pRecord[header.pointFlagOffset] = static_cast<char>(rPoint._ucFlag);
+    });
+    uint64_t ulBytes = header.countPoints * sizeof(MeshPoint);
+    rclOut.write(padding.data(), static_cast<std::streamsize>(header.facetsOffset - header.pointsOffset - ulBytes));
+
+    WriteRecords(rclOut, rFacets.data(), rFacets.size(),
+                 [&header](const MeshFacet& rFacet, char* pRecord) {
+        std::memcpy(pRecord + header.facetPointsOffset, rFacet._aulPoints, 3 * sizeof(PointIndex));
+        std::memcpy(pRecord + header.facetNeighboursOffset, rFacet._aulNeighbours, 3 * sizeof(FacetIndex));
+        pRecord[header.facetFlagOffset] = static_cast<char>(rFacet._ucFlag);
+    });
+}
+
+void MeshKernel::Read (std::istream &rclIn, bool bValidate)
+{
+    if (!rclIn || rclIn.bad())
+        return;
+
+    // Read the header with a "magic number" and a version
+    MeshImageHeader header;
+    const std::streamsize ulStart = 2 * sizeof(uint32_t);
+    if (!rclIn.read(reinterpret_cast<char*>(&header), ulStart))
+        throw Base::BadFormatError("Reading from stream failed");
+
+    if (IsImageHeader(header)) {
+        if (!rclIn.read(reinterpret_cast<char*>(&header) + ulStart, sizeof(header) - ulStart))
+            throw Base::BadFormatError("Reading from stream failed");
+        bool bSwap = CheckImageHeader(header, 0);
+        bool bNative = IsNativeImage(header, bSwap);
+
+        try {
+            MeshPointArray pointArray(static_cast<PointIndex>(header.countPoints));
+            MeshFacetArray facetArray(static_cast<FacetIndex>(header.countFacets));
+
+            SkipBytes(rclIn, header.pointsOffset - sizeof(header));
+            if (bNative) {
+                if (!pointArray.empty() && !rclIn.read(reinterpret_cast<char*>(pointArray.data()),
+                        static_cast<std::streamsize>(pointArray.size() * sizeof(MeshPoint))))
+                    throw Base::BadFormatError("Reading from stream failed");
+            }
+            else {
+                ReadRecords(rclIn, header.pointSize, pointArray.begin(), pointArray.size(),
+                    [&](const char* pData, MeshPointArray::_TIterator it, std::size_t ulCount) {
+                        DecodePoints(header, bSwap, pData, it, ulCount);
+                    });
+            }
+
+            SkipBytes(rclIn, header.facetsOffset - header.pointsOffset - header.countPoints * header.pointSize);
+            if (bNative) {
+                if (!facetArray.empty() && !rclIn.read(reinterpret_cast<char*>(facetArray.data()),
+                        static_cast<std::streamsize>(facetArray.size() * sizeof(MeshFacet))))
+                    throw Base::BadFormatError("Reading from stream failed");
             }
+            else {
+                ReadRecords(rclIn, header.facetSize, facetArray.begin(), facetArray.size(),
+                    [&](const char* pData, MeshFacetArray::_TIterator it, std::size_t ulCount) {
+                        DecodeFacets(header, bSwap, pData, it, ulCount);
+                    });
+            }
+
+            if (bValidate)
+                ValidateIndices(pointArray, facetArray);
+
+            // If we reach this block no exception occurred and we can safely assign the mesh
+            AssignArrays(pointArray, facetArray);
+            _ulGeneration++;
+            _ulTopologyGeneration++;
+            SetImageBoundBox(header, _clBoundBox);
+            _bBoxDirty = false;
+        }
+        catch (Base::Exception&) {
+            throw;
         }
+        catch (std::exception&) {
+            // Special handling of std::length_error
+            throw Base::BadFormatError("Reading from stream failed");
+        }
+        return;
+    }
+
+    // the older formats are stored in little endian
+    uint32_t magic = header.magic, version = header.version, swap_magic, swap_version;
+    if (!IsLittleEndian()) {
+        Base::SwapEndian(magic);
+        Base::SwapEndian(version);
     }
+    Base::InputStream str(rclIn);
+    swap_magic = magic; Base::SwapEndian(swap_magic);
+    swap_version = version; Base::SwapEndian(swap_version);
+    uint32_t open_edge = 0xffffffff; // value to mark an open edge
 
-    // delete facets, number of valid facets
-    unsigned long ulDelFacets = std::count_if(_aclFacetArray.begin(), _aclFacetArray.end(),
-                                              [](const MeshFacet& f) { return f.IsValid(); });
-    MeshFacetArray aclFArray(ulDelFacets);
-    MeshFacetArray::_TIterator pFTemp = aclFArray.begin();  
-    pFEnd  = _aclFacetArray.end();
-    for (pFIter = _aclFacetArray.begin(); pFIter != pFEnd; ++pFIter) {
-        if (pFIter->IsValid() == true)
-            *pFTemp++ = *pFIter;
+    // is it the new or old format?
+    bool new_format = false;
+    if (magic == 0xA0B0C0D0 && version == 0x010000) {
+        new_format = true;
+    }
+    else if (swap_magic == 0xA0B0C0D0 && swap_version == 0x010000) {
+        new_format = true;
+        str.setByteOrder(Base::Stream::BigEndian);
     }
 
-    // free memory
-    //_aclFacetArray = aclFArray;
-    _aclFacetArray.swap(aclFArray);
+    if (new_format) {
+        char szInfo[256];
+        rclIn.read(szInfo, 256);
+
+        // read the number of points and facets
+        uint32_t uCtPts=0, uCtFts=0;
+        str >> uCtPts >> uCtFts;
+
+        try {
+            // read the data
+            MeshPointArray pointArray;
+            pointArray.resize(uCtPts);
+            for (MeshPointArray::_TIterator it = pointArray.begin(); it != pointArray.end(); ++it) {
+                str >> it->x >> it->y >> it->z;
+            }
+
+            MeshFacetArray facetArray;
+            facetArray.resize(uCtFts);
+
+            uint32_t v1, v2, v3;
+            for (MeshFacetArray::_TIterator it = facetArray.begin(); it != facetArray.end(); ++it) {
+                str >> v1 >> v2 >> v3;
+
+                // make sure to have valid indices
+                if (v1 >= uCtPts || v2 >= uCtPts || v3 >= uCtPts)
+                    throw Base::BadFormatError("Invalid data structure");
+
+                it->_aulPoints[0] = v1;
+                it->_aulPoints[1] = v2;
+                it->_aulPoints[2] = v3;
+
+                // On systems where a facet index is a 64-bit value
+                // the empty neighbour must be explicitly set to 'FACET_INDEX_MAX'
+                // because in algorithms this value is always used to check
+                // for open edges.
+                str >> v1 >> v2 >> v3;
+
+                // make sure to have valid indices
+                if (v1 >= uCtFts && v1 < open_edge)
+                    throw Base::BadFormatError("Invalid data structure");
+                if (v2 >= uCtFts && v2 < open_edge)
+                    throw Base::BadFormatError("Invalid data structure");
+                if (v3 >= uCtFts && v3 < open_edge)
+                    throw Base::BadFormatError("Invalid data structure");
+
+                if (v1 < open_edge)
+                    it->_aulNeighbours[0] = v1;
+                else
+                    it->_aulNeighbours[0] = FACET_INDEX_MAX;
+
+                if (v2 < open_edge)
+                    it->_aulNeighbours[1] = v2;
+                else
+                    it->_aulNeighbours[1] = FACET_INDEX_MAX;
+
+                if (v3 < open_edge)
+                    it->_aulNeighbours[2] = v3;
+                else
+                    it->_aulNeighbours[2] = FACET_INDEX_MAX;
+            }
+
+            str >> _clBoundBox.MinX >> _clBoundBox.MaxX;
+            str >> _clBoundBox.MinY >> _clBoundBox.MaxY;
+            str >> _clBoundBox.MinZ >> _clBoundBox.MaxZ;
+
+            // If we reach this block no exception occurred and we can safely assign the mesh
+            AssignArrays(pointArray, facetArray);
+            _ulGeneration++;
+            _ulTopologyGeneration++;
+            _bBoxDirty = false;
+        }
+        catch (std::exception&) {
+            // Special handling of std::length_error
+            throw Base::BadFormatError("Reading from stream failed");
+        }
+    }
+    else {
+        // The old formats
+        unsigned long uCtPts=magic, uCtFts=version;
+        MeshPointArray pointArray;
+        MeshFacetArray facetArray;
+
+        float ratio = 0;
+        if (uCtPts > 0) {
+            ratio = static_cast<float>(uCtFts) / static_cast<float>(uCtPts);
+        }
+
+        // without edge array
+        if (ratio < 2.5f) {
+            // the stored mesh kernel might be empty
+            if (uCtPts > 0) {
+                pointArray.resize(uCtPts);
+                rclIn.read((char*)&(pointArray[0]), uCtPts*sizeof(MeshPoint));
+            }
+            if (uCtFts > 0) {
+                facetArray.resize(uCtFts);
+                rclIn.read((char*)&(facetArray[0]), uCtFts*sizeof(MeshFacet));
+            }
+            rclIn.read((char*)&_clBoundBox, sizeof(Base::BoundBox3f));
+        }
+        else {
+            // with edge array
+            unsigned long uCtEdges=uCtFts;
+            str >> magic;
+            uCtFts = magic;
+            pointArray.resize(uCtPts);
+            for (MeshPointArray::_TIterator it = pointArray.begin(); it != pointArray.end(); ++it) {
+                str >> it->x >> it->y >> it->z;
+            }
+            uint32_t dummy;
+            for (unsigned long i=0; i<uCtEdges; i++) {
+                str >> dummy;
+            }
+            uint32_t v1, v2, v3;
+            facetArray.resize(uCtFts);
+            for (MeshFacetArray::_TIterator it = facetArray.begin(); it != facetArray.end(); ++it) {
+                str >> v1 >> v2 >> v3;
+                it->_aulNeighbours[0] = v1;
+                it->_aulNeighbours[1] = v2;
+                it->_aulNeighbours[2] = v3;
+                str >> v1 >> v2 >> v3;
+                it->_aulPoints[0] = v1;
+                it->_aulPoints[1] = v2;
+                it->_aulPoints[2] = v3;
+                str >> it->_ucFlag;
+            }
+
+            str >> _clBoundBox.MinX
+                >> _clBoundBox.MinY
+                >> _clBoundBox.MinZ
+                >> _clBoundBox.MaxX
+                >> _clBoundBox.MaxY
+                >> _clBoundBox.MaxZ;
+        }
+
+        for (auto it = facetArray.begin(); it != facetArray.end(); ++it) {
+            for (int i=0; i<3; i++) {
+                if (it->_aulPoints[i] >= uCtPts)
+                    throw Base::BadFormatError("Invalid data structure");
+                if (it->_aulNeighbours[i] < FACET_INDEX_MAX && it->_aulNeighbours[i] >= uCtFts)
+                    throw Base::BadFormatError("Invalid data structure");
+            }
+        }
+
+        AssignArrays(pointArray, facetArray);
+        _ulGeneration++;
+        _ulTopologyGeneration++;
+        _bBoxDirty = false;
+    }
 }
 
-MeshFacetArray MeshKernel::GetFacets(const std::vector<unsigned long>& indices) const
+void MeshKernel::GetImageFacets (std::istream &rclIn, uint64_t& rulCount, uint64_t& rulOffset)
 {
-    MeshFacetArray ary;
-    ary.reserve(indices.size());
-    for (std::vector<unsigned long>::const_iterator it = indices.begin(); it != indices.end(); ++it)
-        ary.push_back(this->_aclFacetArray[*it]);
-    return ary;
+    MeshImageHeader header;
+    if (!rclIn.read(reinterpret_cast<char*>(&header), sizeof(header)) || !IsImageHeader(header))
+        throw Base::BadFormatError("Not a mesh image");
+    bool bSwap = CheckImageHeader(header, 0);
+    if (!IsNativeImage(header, bSwap))
+        throw Base::BadFormatError("Mesh image has a foreign record layout");
+
+    rulCount = header.countFacets;
+    rulOffset = header.facetsOffset;
 }
 
+void MeshKernel::Map (const std::string& rclFileName, bool bValidate)
+{
+    std::shared_ptr<MeshMappedFile> file = std::make_shared<MeshMappedFile>(rclFileName);
+
+    MeshImageHeader header;
+    if (file->Size() < sizeof(header))
+        throw Base::BadFormatError("Not a mesh image");
+    std::memcpy(&header, file->Data(), sizeof(header));
+    if (!IsImageHeader(header))
+        throw Base::BadFormatError("Not a mesh image");
+    bool bSwap = CheckImageHeader(header, file->Size());
+
+    MeshPointArray pointArray;
+    MeshFacetArray facetArray;
+    if (IsNativeImage(header, bSwap)) {
+        // the arrays keep the mapping alive
+        AdoptMappedRecords(pointArray, file, header.pointsOffset, header.countPoints);
+        AdoptMappedRecords(facetArray, file, header.facetsOffset, header.countFacets);
+    }
+    else {
+        // different layout, the mapping is only needed for the conversion
+        pointArray.resize(static_cast<PointIndex>(header.countPoints));
+        facetArray.resize(static_cast<FacetIndex>(header.countFacets));
+        DecodePoints(header, bSwap, file->Data() + header.pointsOffset, pointArray.begin(), pointArray.size());
+        DecodeFacets(header, bSwap, file->Data() + header.facetsOffset, facetArray.begin(), facetArray.size());
+    }
+
+    if (bValidate)
+        ValidateIndices(pointArray, facetArray);
+
+    AssignArrays(pointArray, facetArray);
+    _ulGeneration++;
+    _ulTopologyGeneration++;
+    SetImageBoundBox(header, _clBoundBox);
+    _bBoxDirty = false;
+}
 
+MeshKernel& MeshKernel::operator = (const MeshKernel &rclMesh)
+{
+    if (this != &rclMesh) {
+        // the arrays are shared until either kernel modifies them
+        _clPoints = rclMesh._clPoints;
+        _clFacets = rclMesh._clFacets;
+        _ulGeneration++;
+        _ulTopologyGeneration++;
+        // the cached analyses of the former mesh are outdated
+        _clTopologyCache.Clear();
+        // the source may recalculate its box concurrently
+        std::lock_guard<std::mutex> lock(rclMesh._clBoxMutex);
+        _clBoundBox = rclMesh._clBoundBox;
+        _bBoxDirty = rclMesh._bBoxDirty.load();
+        _bValid = rclMesh._bValid;
+    }
+    return *this;
+}
 
-// void MeshKernel::Write (std::ostream &rclOut) const 
-// {
-//     if (!rclOut || rclOut.bad())
-//         return;
-
-//     Base::OutputStream str(rclOut);
-
-//     // Write a header with a "magic number" and a version
-//     str << static_cast<uint32_t>(0xA0B0C0D0);
-//     str << static_cast<uint32_t>(0x010000);
-
-//     char szInfo[257]; // needs an additional byte for zero-termination
-//     strcpy(szInfo, "MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-"
-//                    "MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-"
-//                    "MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-"
-//                    "MESH-MESH-MESH-\n");
-//     rclOut.write(szInfo, 256);
-
-//     // write the number of points and facets
-//     str << static_cast<uint32_t>(CountPoints()) << static_cast<uint32_t>(CountFacets());
-
-//     // write the data
-//     for (MeshPointArray::_TConstIterator it = _aclPointArray.begin(); it != _aclPointArray.end(); ++it) {
-//         str << it->x << it->y << it->z;
-//     }
-
-//     for (MeshFacetArray::_TConstIterator it = _aclFacetArray.begin(); it != _aclFacetArray.end(); ++it) {
-//         str << static_cast<uint32_t>(it->_aulPoints[0])
-//             << static_cast<uint32_t>(it->_aulPoints[1])
-//             << static_cast<uint32_t>(it->_aulPoints[2]);
-//         str << static_cast<uint32_t>(it->_aulNeighbours[0])
-//             << static_cast<uint32_t>(it->_aulNeighbours[1])
-//             << static_cast<uint32_t>(it->_aulNeighbours[2]);
-//     }
-
-//     str << _clBoundBox.MinX << _clBoundBox.MaxX;
-//     str << _clBoundBox.MinY << _clBoundBox.MaxY;
-//     str << _clBoundBox.MinZ << _clBoundBox.MaxZ;
-// }
-
-
-// void MeshKernel::Read (std::istream &rclIn)
-// {
-//     if (!rclIn || rclIn.bad())
-//         return;
-
-//     // get header
-//     Base::InputStream str(rclIn);
-
-//     // Read the header with a "magic number" and a version
-//     uint32_t magic, version, swap_magic, swap_version;
-//     str >> magic >> version;
-//     swap_magic = magic; Base::SwapEndian(swap_magic);
-//     swap_version = version; Base::SwapEndian(swap_version);
-//     uint32_t open_edge = 0xffffffff; // value to mark an open edge
-
-//     // is it the new or old format?
-//     bool new_format = false;
-//     if (magic == 0xA0B0C0D0 && version == 0x010000) {
-//         new_format = true;
-//     }
-//     else if (swap_magic == 0xA0B0C0D0 && swap_version == 0x010000) {
-//         new_format = true;
-//         str.setByteOrder(Base::Stream::BigEndian);
-//     }
-
-//     if (new_format) {
-//         char szInfo[256];
-//         rclIn.read(szInfo, 256);
-
-//         // read the number of points and facets
-//         uint32_t uCtPts=0, uCtFts=0;
-//         str >> uCtPts >> uCtFts;
-
-//         try {
-//             // read the data
-//             MeshPointArray pointArray;
-//             pointArray.resize(uCtPts);
-//             for (MeshPointArray::_TIterator it = pointArray.begin(); it != pointArray.end(); ++it) {
-//                 str >> it->x >> it->y >> it->z;
-//             }
-          
-//             MeshFacetArray facetArray;
-//             facetArray.resize(uCtFts);
-
-//             uint32_t v1, v2, v3;
-//             for (MeshFacetArray::_TIterator it = facetArray.begin(); it != facetArray.end(); ++it) {
-//                 str >> v1 >> v2 >> v3;
-
-//                 // make sure to have valid indices
-//                 if (v1 >= uCtPts || v2 >= uCtPts || v3 >= uCtPts)
-//                     throw Base::BadFormatError("Invalid data structure");
-
-//                 it->_aulPoints[0] = v1;
-//                 it->_aulPoints[1] = v2;
-//                 it->_aulPoints[2] = v3;
-
-//                 // On systems where an 'unsigned long' is a 64-bit value
-//                 // the empty neighbour must be explicitly set to 'ULONG_MAX'
-//                 // because in algorithms this value is always used to check
-//                 // for open edges.
-//                 str >> v1 >> v2 >> v3;
-
-//                 // make sure to have valid indices
-//                 if (v1 >= uCtFts && v1 < open_edge)
-//                     throw Base::BadFormatError("Invalid data structure");
-//                 if (v2 >= uCtFts && v2 < open_edge)
-//                     throw Base::BadFormatError("Invalid data structure");
-//                 if (v3 >= uCtFts && v3 < open_edge)
-//                     throw Base::BadFormatError("Invalid data structure");
-
-//                 if (v1 < open_edge)
-//                     it->_aulNeighbours[0] = v1;
-//                 else
-//                     it->_aulNeighbours[0] = ULONG_MAX;
-
-//                 if (v2 < open_edge)
-//                     it->_aulNeighbours[1] = v2;
-//                 else
-//                     it->_aulNeighbours[1] = ULONG_MAX;
-
-//                 if (v3 < open_edge)
-//                     it->_aulNeighbours[2] = v3;
-//                 else
-//                     it->_aulNeighbours[2] = ULONG_MAX;
-//             }
-
-//             str >> _clBoundBox.MinX >> _clBoundBox.MaxX;
-//             str >> _clBoundBox.MinY >> _clBoundBox.MaxY;
-//             str >> _clBoundBox.MinZ >> _clBoundBox.MaxZ;
-
-//             // If we reach this block no exception occurred and we can safely assign the mesh
-//             _aclPointArray.swap(pointArray);
-//             _aclFacetArray.swap(facetArray);
-//         }
-//         catch (std::exception&) {
-//             // Special handling of std::length_error
-//             throw Base::BadFormatError("Reading from stream failed");
-//         }
-//     }
-//     else {
-//         // The old formats
-//         unsigned long uCtPts=magic, uCtFts=version;
-//         MeshPointArray pointArray;
-//         MeshFacetArray facetArray;
-
-//         float ratio = 0;
-//         if (uCtPts > 0) {
-//             ratio = static_cast<float>(uCtFts) / static_cast<float>(uCtPts);
-//         }
-
-//         // without edge array
-//         if (ratio < 2.5f) {
-//             // the stored mesh kernel might be empty
-//             if (uCtPts > 0) {
-//                 pointArray.resize(uCtPts);
-//                 rclIn.read((char*)&(pointArray[0]), uCtPts*sizeof(MeshPoint));
-//             }
-//             if (uCtFts > 0) {
-//                 facetArray.resize(uCtFts);
-//                 rclIn.read((char*)&(facetArray[0]), uCtFts*sizeof(MeshFacet));
-//             }
-//             rclIn.read((char*)&_clBoundBox, sizeof(Base::BoundBox3f));
-//         }
-//         else {
-//             // with edge array
-//             unsigned long uCtEdges=uCtFts;
-//             str >> magic;
-//             uCtFts = magic;
-//             pointArray.resize(uCtPts);
-//             for (MeshPointArray::_TIterator it = pointArray.begin(); it != pointArray.end(); ++it) {
-//                 str >> it->x >> it->y >> it->z;
-//             }
-//             uint32_t dummy;
-//             for (unsigned long i=0; i<uCtEdges; i++) {
-//                 str >> dummy;
-//             }
-//             uint32_t v1, v2, v3;
-//             facetArray.resize(uCtFts);
-//             for (MeshFacetArray::_TIterator it = facetArray.begin(); it != facetArray.end(); ++it) {
-//                 str >> v1 >> v2 >> v3;
-//                 it->_aulNeighbours[0] = v1;
-//                 it->_aulNeighbours[1] = v2;
-//                 it->_aulNeighbours[2] = v3;
-//                 str >> v1 >> v2 >> v3;
-//                 it->_aulPoints[0] = v1;
-//                 it->_aulPoints[1] = v2;
-//                 it->_aulPoints[2] = v3;
-//                 str >> it->_ucFlag;
-//             }
-
-//             str >> _clBoundBox.MinX
-//                 >> _clBoundBox.MinY
-//                 >> _clBoundBox.MinZ
-//                 >> _clBoundBox.MaxX
-//                 >> _clBoundBox.MaxY
-//                 >> _clBoundBox.MaxZ;
-//         }
-
-//         for (auto it = facetArray.begin(); it != facetArray.end(); ++it) {
-//             for (int i=0; i<3; i++) {
-//                 if (it->_aulPoints[i] >= uCtPts)
-//                     throw Base::BadFormatError("Invalid data structure");
-//                 if (it->_aulNeighbours[i] < ULONG_MAX && it->_aulNeighbours[i] >= uCtFts)
-//                     throw Base::BadFormatError("Invalid data structure");
-//             }
-//         }
-
-//         _aclPointArray.swap(pointArray);
-//         _aclFacetArray.swap(facetArray);
-//     }
-// }
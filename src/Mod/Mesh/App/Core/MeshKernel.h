@@ -25,10 +25,15 @@
 #define MESH_KERNEL_H
 
 #include <assert.h>
+#include <atomic>
 #include <iosfwd>
+#include <mutex>
+#include <string>
 
 #include "Elements.h"
 #include "Helpers.h"
+#include "Storage.h"
+#include "TopologyCache.h"
 
 #include <Base/BoundBox.h>
 #include <Base/Vector3D.h>
@@ -49,15 +54,20 @@ class MeshFacet;
 class MeshFacetVisitor;
 class MeshPointVisitor;
 class MeshFacetGrid;
+class FlagBitmap;
+class ThreadPool;
 
 
 /** 
  * The MeshKernel class is the basic class that holds the data points,
  * the edges and the facets describing a mesh object.
  * 
- * The bounding box is calculated during the buildup of the data
- * structure and gets only re-caclulated after insertion of new facets
- * but not after removal of facets.
+ * The bounding box is extended when points are added. Operations that remove or
+ * replace points only mark it as outdated, it is then recalculated on the next
+ * call of GetBoundBox(). This may happen from several threads at once.
+ *
+ * Each modification of the facets changes the generation of the kernel, which
+ * invalidates the cached topology analyses, see GetTopologyCache().
  *
  * This class provides only some rudimental querying methods.
  */
@@ -68,6 +78,16 @@ public:
     MeshKernel (void);
     /// Construction
     MeshKernel (const MeshKernel &rclMesh);
+    /**
+     * Copies the mesh \a rclMesh in constant time. Both kernels share the point and
+     * facet arrays until one of them modifies an array, which then copies it first.
+     * This also holds for the facet flags, e.g. set by MeshAlgorithm.
+     */
+    MeshKernel& operator = (const MeshKernel &rclMesh);
+    /// Construction, takes the points and facets of \a rclMesh, which is left empty
+    MeshKernel (MeshKernel &&rclMesh) noexcept;
+    /** Takes the points and facets of \a rclMesh, which is left empty. */
+    MeshKernel& operator = (MeshKernel &&rclMesh) noexcept;
     /// Destruction
     ~MeshKernel (void)
     { Clear(); }
@@ -78,14 +98,46 @@ public:
 
     /** @name I/O methods */
     //@{
-    /// Binary streaming of data
+    /**
+     * Binary streaming of data. The points and facets including the neighbourhood
+     * are written as verbatim records at page-aligned offsets, so that the
+     * result can be mapped with Map().
+     */
     void Write (std::ostream &rclOut) const;
-    void Read (std::istream &rclIn);
+    /**
+     * Reads the binary format written by Write() and also the older formats.
+     * If \a bValidate is false the point and neighbour indices of the current
+     * format are not checked. A Base::BadFormatError is thrown on error.
+     */
+    void Read (std::istream &rclIn, bool bValidate = true);
+    /**
+     * Maps the file \a rclFileName written by Write() into memory. If it was
+     * written on a machine with the same record layout the mapped memory is used
+     * directly as point and facet array, so that only the pages that get accessed
+     * are loaded. Modified pages are private to this kernel, the file is never
+     * changed. Otherwise the records are converted like with Read().
+     * The unmodified pages are read from the file as long as this kernel or a copy
+     * of it uses them. Hence the file must neither be modified nor truncated in the
+     * meantime, e.g. by writing the kernel to the same path: modifications show
+     * up in the kernel and accessing a truncated page raises SIGBUS. Write to a
+     * temporary file and rename it instead.
+     */
+    void Map (const std::string& rclFileName, bool bValidate = true);
+    /**
+     * Reads the header of a binary mesh image written by Write() from \a rclIn and
+     * returns the number of facets and the offset of the first facet record from
+     * the start of the image. A Base::BadFormatError is thrown if \a rclIn is no
+     * image or its records do not have the layout of this machine.
+     */
+    static void GetImageFacets (std::istream &rclIn, uint64_t& rulCount, uint64_t& rulOffset);
     //@}
 
+    /// Returns the number of points
+    unsigned long CountPoints (void) const
+    { return static_cast<unsigned long>(_clPoints.Get().size()); }
     /// Returns the number of facets
     unsigned long CountFacets (void) const
-    { return static_cast<unsigned long>(_aclFacetArray.size()); }
+    { return static_cast<unsigned long>(_clFacets.Get().size()); }
 
     /**
      * This method visits all neighbour facets, i.e facets that share a common edge 
@@ -98,26 +150,107 @@ public:
      * \note For the start facet \a ulStartFacet MeshFacetVisitor::Visit() does not get invoked though
      * the facet gets marked as VISIT.
      */
-    unsigned long VisitNeighbourFacets (MeshFacetVisitor &rclFVisitor, unsigned long ulStartFacet) const;
+    unsigned long VisitNeighbourFacets (MeshFacetVisitor &rclFVisitor, FacetIndex ulStartFacet) const;
+    /**
+     * Does the same as the method above but keeps the visited facets in \a rclVisited
+     * instead of the VISIT flag of the facets. The kernel is not modified, thus several
+     * threads can traverse the same kernel at the same time, each with its own bitmap.
+     */
+    unsigned long VisitNeighbourFacets (MeshFacetVisitor &rclFVisitor, FacetIndex ulStartFacet,
+                                        FlagBitmap& rclVisited) const;
     
-    /** Removes all as INVALID marked points and facets from the structure. */
-    void RemoveInvalids ();
+    /**
+     * Replaces the points and facets with \a rPoints and \a rFacets by swapping the
+     * arrays, so \a rPoints and \a rFacets get the old data. An old array that is
+     * still shared with a copy of the kernel is not handed back, the argument is
+     * empty then. If \a checkNeighbourHood is true the neighbourhood of the facets
+     * is rebuilt from their corner points.
+     */
+    void Adopt (MeshPointArray& rPoints, MeshFacetArray& rFacets, bool checkNeighbourHood = false);
+    /**
+     * Replaces the points and facets with \a rPoints and \a rFacets, e.g. freshly
+     * built arrays, without copying them. The old arrays are released.
+     */
+    void Adopt (MeshPointArray&& rPoints, MeshFacetArray&& rFacets, bool checkNeighbourHood = false);
+    /** Swaps the content of this kernel and \a rclMesh. */
+    void Swap (MeshKernel& rclMesh);
+    /**
+     * Rebuilds the neighbour indices of all facets from their corner points, using
+     * \a pool if given. Edges shared by more than two facets are left open.
+     * Returns the number of such non-manifold edges.
+     */
+    unsigned long RebuildNeighbours (ThreadPool* pool = nullptr);
+    /** Recalculates the bounding box from the points, using \a pool if given. */
+    void RecalcBoundBox (ThreadPool* pool = nullptr);
+    /**
+     * Returns the bounding box of all points. If the box is outdated it is
+     * recalculated first, using \a pool if given. Concurrent calls are safe, only
+     * one of them recalculates the box while the others wait for it.
+     */
+    const Base::BoundBox3f& GetBoundBox (ThreadPool* pool = nullptr) const;
+    /**
+     * Removes all as INVALID marked points and facets from the structure. The arrays
+     * are compacted in place, using \a pool if given. A valid facet that references a
+     * removed point afterwards references the next valid point. Indices out of range
+     * are kept.
+     */
+    void RemoveInvalids (ThreadPool* pool = nullptr);
+    /**
+     * Renumbers the points and facets, using \a pool if given. The point with index i
+     * afterwards is the point \a rulPointOrder[i] before, the same holds for the facets
+     * and \a rulFacetOrder. Both arrays must be permutations of all indices. The corner
+     * and neighbour indices of the facets are changed accordingly.
+     * @see MeshReorder
+     */
+    void Permute (const std::vector<PointIndex>& rulPointOrder, const std::vector<FacetIndex>& rulFacetOrder,
+                  ThreadPool* pool = nullptr);
     /** Clears the whole data structure. */
     void Clear (void);
-        /** Returns the array of all facets */
-    const MeshFacetArray& GetFacets (void) const { return _aclFacetArray; }
+    /**
+     * Returns the array of all data points. The reference may become invalid with
+     * the next modification of the kernel, e.g. if the array is shared with a copy.
+     */
+    const MeshPointArray& GetPoints (void) const { return _clPoints.Get(); }
+    /** Returns the array of all facets, see GetPoints(). */
+    const MeshFacetArray& GetFacets (void) const { return _clFacets.Get(); }
+    /** Returns the generation of the kernel, it changes whenever the facets are modified. */
+    uint64_t GetGeneration (void) const { return _ulGeneration; }
+    /**
+     * Returns the topology generation of the kernel. Unlike GetGeneration() it does
+     * not change if only the orientation of facets is flipped.
+     */
+    uint64_t GetTopologyGeneration (void) const { return _ulTopologyGeneration; }
+    /**
+     * Returns the cache of topology analyses, e.g. the components used by
+     * MeshEvalOrientation. The cache is filled on demand by the evaluation that
+     * reserves it with MeshTopologyCache::Acquire(), which never waits. Concurrent
+     * evaluations of the same kernel that fail to reserve it use a private cache
+     * for this call instead, so they neither block nor share results.
+     */
+    MeshTopologyCache& GetTopologyCache (void) const { return _clTopologyCache; }
     /** Returns an array of facets to the given indices. The indices
      * must not be out of range.
      */
-    MeshFacetArray GetFacets(const std::vector<unsigned long>&) const;
+    MeshFacetArray GetFacets(const std::vector<FacetIndex>&) const;
 
 
 protected:
+    /**
+     * Replaces both arrays with \a rPoints and \a rFacets, see Adopt(). Either both
+     * arrays are replaced or, if an exception is thrown, none of them.
+     */
+    void AssignArrays (MeshPointArray& rPoints, MeshFacetArray& rFacets);
 
-    MeshPointArray   _aclPointArray; /**< Holds the array of geometric points. */
-    MeshFacetArray   _aclFacetArray; /**< Holds the array of facets. */
-    Base::BoundBox3f _clBoundBox;    /**< The current calculated bounding box. */
+    MeshSharedArray<MeshPointArray> _clPoints; /**< Holds the array of geometric points. */
+    /** Holds the array of facets, mutable as the facet flags can be set on a const kernel. */
+    mutable MeshSharedArray<MeshFacetArray> _clFacets;
+    mutable Base::BoundBox3f _clBoundBox; /**< The current calculated bounding box. */
+    mutable std::atomic<bool> _bBoxDirty; /**< The bounding box must be recalculated. */
+    mutable std::mutex _clBoxMutex; /**< Serializes the recalculation in GetBoundBox(). */
     bool            _bValid; /**< Current state of validality. */
+    uint64_t        _ulGeneration; /**< Changed by each modification of the facets. */
+    uint64_t        _ulTopologyGeneration; /**< Changed by each modification of the neighbourhood. */
+    mutable MeshTopologyCache _clTopologyCache; /**< Analyses of the current generation. */
 
     // friends
     friend class MeshAlgorithm;
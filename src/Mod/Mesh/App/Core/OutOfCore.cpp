@@ -0,0 +1,327 @@
+/***************************************************************************
+ *   Copyright (c) 2026 The mesh-repair contributors                       *
+ *                                                                         *
+ *   This file is part of mesh-repair, which is based on FreeCAD.          *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# include <algorithm>
+#endif
+
+#include <Base/Exception.h>
+
+#include "OutOfCore.h"
+#include "MeshKernel.h"
+#include "Trace.h"
+
+using namespace MeshCore;
+
+namespace {
+
+/**
+ * Union-find that keeps the parity of each element relative to the root of its set,
+ * where a root is always the smallest index of its set. Returns the root of \a i
+ * and its parity in \a rucParity.
+ */
+FacetIndex FindParity (std::vector<FacetIndex>& rulParent, std::vector<unsigned char>& rucParity,
+                       FacetIndex i, unsigned char& rucRootParity)
+{
+    FacetIndex ulRoot = i;
+    unsigned char ucParity = 0;
+    while (rulParent[ulRoot] != ulRoot) {
+        ucParity ^= rucParity[ulRoot];
+        ulRoot = rulParent[ulRoot];
+    }
+
+    // path compression
+    unsigned char ucCurrent = ucParity;
+    while (rulParent[i] != ulRoot && rulParent[i] != i) {
+        FacetIndex ulNext = rulParent[i];
+        unsigned char ucNext = ucCurrent ^ rucParity[i];
+        rulParent[i] = ulRoot;
+        rucParity[i] = ucCurrent;
+        i = ulNext;
+        ucCurrent = ucNext;
+    }
+
+    rucRootParity = ucParity;
+    return ulRoot;
+}
+
+/**
+ * Merges the sets of \a a and \a b so that their parities differ by \a ucRelation.
+ * Returns false if they are already in one set with a contradicting parity.
+ */
+bool UniteParity (std::vector<FacetIndex>& rulParent, std::vector<unsigned char>& rucParity,
+                  FacetIndex a, FacetIndex b, unsigned char ucRelation)
+{
+    unsigned char ucA, ucB;
+    a = FindParity(rulParent, rucParity, a, ucA);
+    b = FindParity(rulParent, rucParity, b, ucB);
+    if (a == b)
+        return (ucA ^ ucB) == ucRelation;
+    if (a > b)
+        std::swap(a, b);
+    rulParent[b] = a;
+    rucParity[b] = ucA ^ ucB ^ ucRelation;
+    return true;
+}
+
+}
+
+MeshOutOfCoreOrientation::MeshOutOfCoreOrientation (const std::string& rclFileName)
+  : _clFileName(rclFileName), _ulCount(0), _ulOffset(0), _ulChunkSize(4 << 20)
+  , _trace(nullptr), _ulFlipped(0), _ulBoundaryLinks(0)
+{
+    _clFile.open(rclFileName.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+    if (!_clFile.is_open())
+        throw Base::FileException("Cannot open file", rclFileName.c_str());
+    MeshKernel::GetImageFacets(_clFile, _ulCount, _ulOffset);
+    // the facets are addressed by FacetIndex, its maximum marks open edges
+    if (_ulCount > uint64_t(FACET_INDEX_MAX))
+        throw Base::BadFormatError("Mesh image has too many facets");
+}
+
+MeshOutOfCoreOrientation::~MeshOutOfCoreOrientation (void)
+{
+}
+
+FacetIndex MeshOutOfCoreOrientation::ChunkEnd (FacetIndex ulBegin) const
+{
+    return static_cast<FacetIndex>(std::min<uint64_t>(_ulCount, ulBegin + uint64_t(_ulChunkSize)));
+}
+
+void MeshOutOfCoreOrientation::ReadChunk (FacetIndex ulBegin, FacetIndex ulEnd)
+{
+    _aclChunk.resize(ulEnd - ulBegin);
+    _clFile.seekg(static_cast<std::streamoff>(_ulOffset + uint64_t(ulBegin) * sizeof(MeshFacet)));
+    if (!_clFile.read(reinterpret_cast<char*>(_aclChunk.data()),
+                      static_cast<std::streamsize>(_aclChunk.size() * sizeof(MeshFacet))))
+        throw Base::FileException("Cannot read file", _clFileName.c_str());
+}
+
+void MeshOutOfCoreOrientation::WriteChunk (FacetIndex ulBegin)
+{
+    _clFile.seekp(static_cast<std::streamoff>(_ulOffset + uint64_t(ulBegin) * sizeof(MeshFacet)));
+    if (!_clFile.write(reinterpret_cast<const char*>(_aclChunk.data()),
+                       static_cast<std::streamsize>(_aclChunk.size() * sizeof(MeshFacet))))
+        throw Base::FileException("Cannot write file", _clFileName.c_str());
+}
+
+bool MeshOutOfCoreOrientation::LabelChunk (FacetIndex ulBegin, FacetIndex& rulNextNode, std::vector<Link>* pLinks)
+{
+    const FacetIndex ulSize = static_cast<FacetIndex>(_aclChunk.size());
+    const FacetIndex ulEnd = ulBegin + ulSize;
+    const FacetIndex ulCount = static_cast<FacetIndex>(_ulCount);
+    const std::size_t ulFirstLink = pLinks ? pLinks->size() : 0;
+
+    _aulLocalParent.resize(ulSize);
+    _aucLocalParity.assign(ulSize, 0);
+    for (FacetIndex i = 0; i < ulSize; i++)
+        _aulLocalParent[i] = i;
+
+    // the facet i has to be flipped relative to its neighbour j if they are not
+    // oriented the same way, exactly like in the region growing
+    for (FacetIndex i = 0; i < ulSize; i++) {
+        const MeshFacet& rclFacet = _aclChunk[i];
+        for (int k = 0; k < 3; k++) {
+            FacetIndex j = rclFacet._aulNeighbours[k];
+            if (j >= ulCount || j == ulBegin + i)
+                continue; // open edge or error in data structure
+            if (j < ulBegin || j >= ulEnd) {
+                if (pLinks) {
+                    Link clLink;
+                    clLink.lo = std::min(j, ulBegin + i);
+                    clLink.hi = std::max(j, ulBegin + i);
+                    clLink.node = i; // replaced by the component below
+                    for (int l = 0; l < 3; l++)
+                        clLink.points[l] = rclFacet._aulPoints[l];
+                    clLink.parity = 0;
+                    clLink.fromLo = clLink.lo == ulBegin + i ? 1 : 0;
+                    pLinks->push_back(clLink);
+                }
+                continue;
+            }
+
+            const MeshFacet& rclNeighbour = _aclChunk[j - ulBegin];
+            if (rclNeighbour._aulNeighbours[0] != ulBegin + i && rclNeighbour._aulNeighbours[1] != ulBegin + i &&
+                rclNeighbour._aulNeighbours[2] != ulBegin + i)
+                return false; // one-sided neighbourhood
+            unsigned char ucRelation = rclFacet.HasSameOrientation(rclNeighbour) ? 0 : 1;
+            if (!UniteParity(_aulLocalParent, _aucLocalParity, i, j - ulBegin, ucRelation))
+                return false; // not orientable
+        }
+    }
+
+    // number the chunk-local components in ascending order of their first facet
+    _aulLocalNode.resize(ulSize);
+    const FacetIndex ulFirstNode = rulNextNode;
+    for (FacetIndex i = 0; i < ulSize; i++) {
+        if (_aulLocalParent[i] == i)
+            _aulLocalNode[i] = rulNextNode++;
+    }
+
+    if (pLinks) {
+        _aulNodeParent.resize(rulNextNode);
+        _aucNodeParity.resize(rulNextNode, 0);
+        _aulNodeSize.resize(rulNextNode, 0);
+        _aulNodeZeros.resize(rulNextNode, 0);
+        for (FacetIndex n = ulFirstNode; n < rulNextNode; n++)
+            _aulNodeParent[n] = n;
+
+        for (FacetIndex i = 0; i < ulSize; i++) {
+            unsigned char ucParity;
+            FacetIndex ulNode = _aulLocalNode[FindParity(_aulLocalParent, _aucLocalParity, i, ucParity)];
+            _aulNodeSize[ulNode]++;
+            if (ucParity == 0)
+                _aulNodeZeros[ulNode]++;
+        }
+
+        for (std::size_t l = ulFirstLink; l < pLinks->size(); l++) {
+            Link& rclLink = (*pLinks)[l];
+            FacetIndex ulRoot = FindParity(_aulLocalParent, _aucLocalParity, rclLink.node, rclLink.parity);
+            rclLink.node = _aulLocalNode[ulRoot];
+        }
+    }
+
+    return true;
+}
+
+bool MeshOutOfCoreOrientation::SolveLinks (std::vector<Link>& rclLinks)
+{
+    std::sort(rclLinks.begin(), rclLinks.end(), [](const Link& a, const Link& b) {
+        if (a.lo != b.lo)
+            return a.lo < b.lo;
+        if (a.hi != b.hi)
+            return a.hi < b.hi;
+        return a.fromLo < b.fromLo;
+    });
+
+    // each link must have been recorded from both sides, after sorting the side of
+    // the higher facet comes first
+    std::size_t i = 0;
+    while (i < rclLinks.size()) {
+        std::size_t j = i + 1;
+        while (j < rclLinks.size() && rclLinks[j].lo == rclLinks[i].lo && rclLinks[j].hi == rclLinks[i].hi)
+            j++;
+        const Link& rclHi = rclLinks[i];
+        const Link& rclLo = rclLinks[j - 1];
+        if (rclHi.fromLo || !rclLo.fromLo)
+            return false; // one-sided neighbourhood
+
+        MeshFacet clHi(rclHi.points[0], rclHi.points[1], rclHi.points[2]);
+        MeshFacet clLo(rclLo.points[0], rclLo.points[1], rclLo.points[2]);
+        unsigned char ucRelation = (clLo.HasSameOrientation(clHi) ? 0 : 1) ^ rclHi.parity ^ rclLo.parity;
+        if (!UniteParity(_aulNodeParent, _aucNodeParity, rclHi.node, rclLo.node, ucRelation))
+            return false; // not orientable
+        i = j;
+    }
+
+    return true;
+}
+
+bool MeshOutOfCoreOrientation::HarmonizeNormals (void)
+{
+    MESH_TRACE_SCOPE(_trace, "OutOfCoreHarmonizeNormals");
+    const FacetIndex ulCount = static_cast<FacetIndex>(_ulCount);
+    _ulFlipped = 0;
+    _ulBoundaryLinks = 0;
+    _aulNodeParent.clear();
+    _aucNodeParity.clear();
+    _aulNodeSize.clear();
+    _aulNodeZeros.clear();
+
+    // resolve the parity inside each chunk and record the links between the chunks
+    std::vector<Link> aclLinks;
+    FacetIndex ulNodes = 0;
+    {
+        MESH_TRACE_SCOPE(_trace, "OutOfCoreLabeling");
+        for (FacetIndex b = 0; b < ulCount; b = ChunkEnd(b)) {
+            ReadChunk(b, ChunkEnd(b));
+            if (!LabelChunk(b, ulNodes, &aclLinks))
+                return false;
+        }
+    }
+
+    // connect the chunk-local components
+    _ulBoundaryLinks = aclLinks.size();
+    {
+        MESH_TRACE_SCOPE(_trace, "OutOfCoreSolving");
+        if (!SolveLinks(aclLinks))
+            return false;
+        std::vector<Link>().swap(aclLinks);
+    }
+
+    // The start facet of a component is the first facet of its first chunk-local
+    // component, i.e. the root. Count the facets of each component that the region
+    // growing finds as false oriented, i.e. with another parity than the start facet.
+    std::vector<unsigned char> aucFlip(ulNodes);
+    std::vector<unsigned long> aulVisited(ulNodes, 0), aulWrong(ulNodes, 0);
+    std::vector<FacetIndex> aulRoot(ulNodes);
+    for (FacetIndex n = 0; n < ulNodes; n++) {
+        aulRoot[n] = FindParity(_aulNodeParent, _aucNodeParity, n, aucFlip[n]);
+        aulVisited[aulRoot[n]] += _aulNodeSize[n];
+        aulWrong[aulRoot[n]] += aucFlip[n] ? _aulNodeZeros[n] : _aulNodeSize[n] - _aulNodeZeros[n];
+    }
+
+    // same 40% rule as in MeshEvalOrientation
+    for (FacetIndex n = 0; n < ulNodes; n++) {
+        FacetIndex r = aulRoot[n];
+        if (r == n) {
+            MESH_TRACE_COUNT(_trace, ComponentsVisited, 1);
+        }
+        unsigned long ulComplement = aulVisited[r] - aulWrong[r];
+        if (ulComplement < static_cast<unsigned long>(0.4f*static_cast<float>(aulVisited[r])))
+            aucFlip[n] ^= 1;
+    }
+    MESH_TRACE_COUNT(_trace, FacetsVisited, ulCount);
+
+    // flip the facets chunk by chunk
+    {
+        MESH_TRACE_SCOPE(_trace, "OutOfCoreFlipping");
+        ulNodes = 0;
+        for (FacetIndex b = 0; b < ulCount; b = ChunkEnd(b)) {
+            ReadChunk(b, ChunkEnd(b));
+            LabelChunk(b, ulNodes, nullptr);
+
+            bool bChanged = false;
+            for (FacetIndex i = 0; i < _aclChunk.size(); i++) {
+                unsigned char ucParity;
+                FacetIndex ulRoot = FindParity(_aulLocalParent, _aucLocalParity, i, ucParity);
+                if (ucParity ^ aucFlip[_aulLocalNode[ulRoot]]) {
+                    _aclChunk[i].FlipNormal();
+                    _ulFlipped++;
+                    bChanged = true;
+                }
+            }
+            if (bChanged)
+                WriteChunk(b);
+        }
+        _clFile.flush();
+        if (!_clFile)
+            throw Base::FileException("Cannot write file", _clFileName.c_str());
+    }
+
+    MESH_TRACE_COUNT(_trace, FlipsApplied, _ulFlipped);
+    return true;
+}
@@ -0,0 +1,140 @@
+/***************************************************************************
+ *   Copyright (c) 2026 The mesh-repair contributors                       *
+ *                                                                         *
+ *   This file is part of mesh-repair, which is based on FreeCAD.          *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef MESH_OUTOFCORE_H
+#define MESH_OUTOFCORE_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Elements.h"
+
+namespace MeshCore {
+
+class MeshTrace;
+
+/**
+ * The MeshOutOfCoreOrientation class harmonizes the normals of a binary mesh image
+ * written by MeshKernel::Write() without loading the facets at once, so that it
+ * works for meshes larger than the memory. The image is changed in place and
+ * afterwards has the same facets as if it had been read, harmonized with
+ * MeshTopoAlgorithm::HarmonizeNormals() and written again.
+ *
+ * The facet records are processed in chunks in three passes:
+ * \li The orientation parity of each facet relative to the facet with the lowest
+ * index of its component inside the chunk is resolved with a union-find. Each link
+ * to a facet of another chunk is recorded together with the corner points of the
+ * facet.
+ * \li The recorded links are paired and the parity relations between the chunk-local
+ * components are solved. This gives each global component, its start facet and the
+ * number of facets the region growing would find as false oriented.
+ * \li Each chunk is read again, the false oriented facets get flipped and the chunk
+ * is written back.
+ *
+ * Memory is needed for one chunk, the chunk-local components and the links across
+ * chunk boundaries. Thus meshes whose facets are stored in spatially coherent order,
+ * e.g. by MeshReorder, need far less memory than meshes in random order.
+ *
+ * The result of the region growing only depends on the topology if the orientation
+ * of every component is consistent. If a component is not orientable, or if a facet
+ * references a neighbour that does not reference it back, the flips depend on the
+ * order of the traversal. Then HarmonizeNormals() returns false and leaves the image
+ * unchanged, and the mesh has to be harmonized in memory.
+ */
+class MeshExport MeshOutOfCoreOrientation
+{
+public:
+    /**
+     * Opens the mesh image \a rclFileName. Throws a Base::FileException if this fails
+     * and a Base::BadFormatError if the image has more facets than FacetIndex can address.
+     */
+    explicit MeshOutOfCoreOrientation (const std::string& rclFileName);
+    ~MeshOutOfCoreOrientation (void);
+
+    /** Sets the number of facets loaded at once, 4M facets by default. */
+    void SetChunkSize (std::size_t ulFacets)
+    { _ulChunkSize = ulFacets > 0 ? ulFacets : 1; }
+    /** Records the passes and counters in \a trace if built with MESH_TRACE. */
+    void SetTrace (MeshTrace* trace)
+    { _trace = trace; }
+
+    /**
+     * Harmonizes the normals of the image. Returns false if the orientation of a
+     * component cannot be resolved out of core, the image is unchanged then.
+     * A Base::BadFormatError is thrown if the file is no native mesh image and a
+     * Base::FileException if reading or writing fails.
+     */
+    bool HarmonizeNormals (void);
+    /** Returns the number of facets flipped by the last call of HarmonizeNormals(). */
+    unsigned long CountFlipped (void) const
+    { return _ulFlipped; }
+    /** Returns the number of links across chunk boundaries recorded by the last run. */
+    std::size_t CountBoundaryLinks (void) const
+    { return _ulBoundaryLinks; }
+
+private:
+    /** One side of a link between facets of different chunks. */
+    struct Link
+    {
+        FacetIndex lo, hi;        /**< The linked facets, ordered by index. */
+        FacetIndex node;          /**< Chunk-local component of the facet of this side. */
+        PointIndex points[3];     /**< Corner points of the facet of this side. */
+        unsigned char parity;     /**< Parity of the facet inside its component. */
+        unsigned char fromLo;     /**< This side is the facet \a lo. */
+    };
+
+    FacetIndex ChunkEnd (FacetIndex ulBegin) const;
+    void ReadChunk (FacetIndex ulBegin, FacetIndex ulEnd);
+    void WriteChunk (FacetIndex ulBegin);
+    bool LabelChunk (FacetIndex ulBegin, FacetIndex& rulNextNode, std::vector<Link>* pLinks);
+    bool SolveLinks (std::vector<Link>& rclLinks);
+
+private:
+    MeshOutOfCoreOrientation (const MeshOutOfCoreOrientation&);
+    void operator = (const MeshOutOfCoreOrientation&);
+
+    std::fstream _clFile;
+    std::string _clFileName;
+    uint64_t _ulCount;
+    uint64_t _ulOffset;
+    std::size_t _ulChunkSize;
+    MeshTrace* _trace;
+    unsigned long _ulFlipped;
+    std::size_t _ulBoundaryLinks;
+
+    std::vector<MeshFacet> _aclChunk;        /**< Facets of the current chunk. */
+    std::vector<FacetIndex> _aulLocalParent; /**< Union-find of the current chunk. */
+    std::vector<unsigned char> _aucLocalParity;
+    std::vector<FacetIndex> _aulLocalNode;   /**< Component of each chunk-local root. */
+    std::vector<FacetIndex> _aulNodeParent;  /**< Union-find of the chunk-local components. */
+    std::vector<unsigned char> _aucNodeParity;
+    std::vector<FacetIndex> _aulNodeSize;    /**< Facets of each chunk-local component. */
+    std::vector<FacetIndex> _aulNodeZeros;   /**< Facets with the parity of the local root. */
+};
+
+} // namespace MeshCore
+
+#endif // MESH_OUTOFCORE_H
@@ -0,0 +1,183 @@
+/***************************************************************************
+ *   Copyright (c) 2026 The mesh-repair contributors                       *
+ *                                                                         *
+ *   This file is part of mesh-repair, which is based on FreeCAD.          *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# include <algorithm>
+# include <cstdint>
+# include <utility>
+#endif
+
+#include "Reorder.h"
+#include "FlagBitmap.h"
+#include "MeshKernel.h"
+#include "ThreadPool.h"
+#include "Traversal.h"
+
+using namespace MeshCore;
+
+namespace {
+
+/** Spreads the lower 21 bits of \a ulBits so that two zero bits follow each bit. */
+inline uint64_t SpreadBits (uint64_t ulBits)
+{
+    ulBits &= 0x1fffff;
+    ulBits = (ulBits | ulBits << 32) & 0x1f00000000ffffULL;
+    ulBits = (ulBits | ulBits << 16) & 0x1f0000ff0000ffULL;
+    ulBits = (ulBits | ulBits << 8)  & 0x100f00f00f00f00fULL;
+    ulBits = (ulBits | ulBits << 4)  & 0x10c30c30c30c30c3ULL;
+    ulBits = (ulBits | ulBits << 2)  & 0x1249249249249249ULL;
+    return ulBits;
+}
+
+/** Maps a scaled coordinate to the 21 bits of a Morton key. */
+inline uint64_t Quantize (float fValue)
+{
+    if (!(fValue > 0.0f))
+        return 0;
+    return std::min<uint64_t>(static_cast<uint64_t>(fValue), 0x1fffff);
+}
+
+/** Collects the facets in the order they get visited. */
+class OrderCollector
+{
+public:
+    explicit OrderCollector (std::vector<FacetIndex>& aulOrder) : _aulOrder(aulOrder) { }
+    bool Visit (const MeshFacet&, const MeshFacet&, FacetIndex ulFInd, unsigned long)
+    {
+        _aulOrder.push_back(ulFInd);
+        return true;
+    }
+
+private:
+    std::vector<FacetIndex>& _aulOrder;
+};
+
+}
+
+MeshReorder::MeshReorder (MeshKernel& rclMesh)
+  : _rclMesh(rclMesh), _pool(nullptr)
+{
+}
+
+MeshReorder::~MeshReorder (void)
+{
+}
+
+void MeshReorder::Reorder (Method tMethod)
+{
+    if (tMethod == Morton)
+        SortByMorton();
+    else
+        SortByBreadth();
+    NumberPoints();
+    _rclMesh.Permute(_aulPointOrder, _aulFacetOrder, _pool);
+}
+
+void MeshReorder::SortByMorton (void)
+{
+    const MeshPointArray& rPoints = _rclMesh.GetPoints();
+    const MeshFacetArray& rFacets = _rclMesh.GetFacets();
+    const std::size_t ulCtPts = rPoints.size();
+    const std::size_t ulCtFts = rFacets.size();
+
+    // the centroids lie inside the bounding box of the points
+    Base::BoundBox3f clBox;
+    for (MeshPointArray::_TConstIterator it = rPoints.begin(); it != rPoints.end(); ++it)
+        clBox.Add(*it);
+    const float fLength = std::max(std::max(clBox.MaxX - clBox.MinX, clBox.MaxY - clBox.MinY),
+                                   clBox.MaxZ - clBox.MinZ);
+    // 21 bits per axis, the centroid is the sum of the corners divided by 3
+    const float fScale = fLength > 0.0f ? float(0x1fffff) / (3.0f * fLength) : 0.0f;
+
+    std::vector<std::pair<uint64_t, FacetIndex> > aulKeys(ulCtFts);
+    ParallelFor(_pool, 0, ulCtFts, GrainSize(_pool, ulCtFts, 4096), [&](std::size_t b, std::size_t e) {
+        for (std::size_t i = b; i < e; i++) {
+            const MeshFacet& rFacet = rFacets[i];
+            uint64_t ulCode = UINT64_MAX; // facets with a broken corner go to the end
+            if (rFacet._aulPoints[0] < ulCtPts && rFacet._aulPoints[1] < ulCtPts && rFacet._aulPoints[2] < ulCtPts) {
+                const MeshPoint& rP0 = rPoints[rFacet._aulPoints[0]];
+                const MeshPoint& rP1 = rPoints[rFacet._aulPoints[1]];
+                const MeshPoint& rP2 = rPoints[rFacet._aulPoints[2]];
+                uint64_t ulX = Quantize((rP0.x + rP1.x + rP2.x - 3.0f * clBox.MinX) * fScale);
+                uint64_t ulY = Quantize((rP0.y + rP1.y + rP2.y - 3.0f * clBox.MinY) * fScale);
+                uint64_t ulZ = Quantize((rP0.z + rP1.z + rP2.z - 3.0f * clBox.MinZ) * fScale);
+                ulCode = SpreadBits(ulX) | SpreadBits(ulY) << 1 | SpreadBits(ulZ) << 2;
+            }
+            aulKeys[i] = std::make_pair(ulCode, static_cast<FacetIndex>(i));
+        }
+    });
+
+    // facets with the same key keep their relative order
+    std::sort(aulKeys.begin(), aulKeys.end());
+
+    _aulFacetOrder.resize(ulCtFts);
+    for (std::size_t i = 0; i < ulCtFts; i++)
+        _aulFacetOrder[i] = aulKeys[i].second;
+}
+
+void MeshReorder::SortByBreadth (void)
+{
+    const MeshFacetArray& rFacets = _rclMesh.GetFacets();
+    const std::size_t ulCtFts = rFacets.size();
+
+    _aulFacetOrder.clear();
+    _aulFacetOrder.reserve(ulCtFts);
+
+    FlagBitmap clVisited(ulCtFts);
+    MeshFacetTraversal clTraversal(rFacets);
+    OrderCollector clCollector(_aulFacetOrder);
+
+    // each component starts at its facet with the lowest index
+    std::size_t ulStart = clVisited.FindFirstReset(0);
+    while (ulStart < ulCtFts) {
+        _aulFacetOrder.push_back(static_cast<FacetIndex>(ulStart));
+        clTraversal.VisitNeighbours(clCollector, static_cast<FacetIndex>(ulStart), clVisited);
+        ulStart = clVisited.FindFirstReset(ulStart + 1);
+    }
+}
+
+void MeshReorder::NumberPoints (void)
+{
+    const MeshFacetArray& rFacets = _rclMesh.GetFacets();
+    const std::size_t ulCtPts = _rclMesh.GetPoints().size();
+
+    _aulPointOrder.clear();
+    _aulPointOrder.reserve(ulCtPts);
+
+    FlagBitmap clNumbered(ulCtPts);
+    for (std::vector<FacetIndex>::const_iterator it = _aulFacetOrder.begin(); it != _aulFacetOrder.end(); ++it) {
+        const MeshFacet& rFacet = rFacets[*it];
+        for (int j = 0; j < 3; j++) {
+            PointIndex ulPt = rFacet._aulPoints[j];
+            if (ulPt < ulCtPts && !clNumbered.TestAndSet(ulPt))
+                _aulPointOrder.push_back(ulPt);
+        }
+    }
+
+    // points not used by any facet
+    for (std::size_t ulPt = clNumbered.FindFirstReset(0); ulPt < ulCtPts; ulPt = clNumbered.FindFirstReset(ulPt + 1))
+        _aulPointOrder.push_back(static_cast<PointIndex>(ulPt));
+}
@@ -0,0 +1,97 @@
+/***************************************************************************
+ *   Copyright (c) 2026 The mesh-repair contributors                       *
+ *                                                                         *
+ *   This file is part of mesh-repair, which is based on FreeCAD.          *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef MESH_REORDER_H
+#define MESH_REORDER_H
+
+#include <vector>
+
+#include "Elements.h"
+
+namespace MeshCore {
+
+class MeshKernel;
+class ThreadPool;
+
+/**
+ * The MeshReorder class renumbers the points and facets of a mesh so that facets
+ * close to each other also lie close to each other in memory. Meshes read from
+ * scanner output are often stored in random order, where every step to a
+ * neighbour facet misses the cache.
+ * The facets are sorted either along a Morton curve through their centroids or
+ * in breadth-first order over the neighbourhood, component by component. The
+ * points are then numbered in the order they are first referenced by the sorted
+ * facets; unreferenced points go to the end.
+ * The applied permutations are kept, so that results computed on the reordered
+ * mesh can be mapped back to the original indices.
+ */
+class MeshExport MeshReorder
+{
+public:
+    enum Method {
+        Morton,  /**< Sort facets along a Morton curve through their centroids. */
+        Breadth  /**< Sort facets in breadth-first order over the neighbourhood. */
+    };
+
+    explicit MeshReorder (MeshKernel& rclMesh);
+    ~MeshReorder (void);
+
+    /**
+     * Sets the thread pool used to compute the sort keys and to permute the arrays.
+     * By default, i.e. if \a pool is null, everything runs on the calling thread.
+     */
+    void SetThreadPool (ThreadPool* pool)
+    { _pool = pool; }
+
+    /** Renumbers the points and facets of the mesh with \a tMethod. */
+    void Reorder (Method tMethod);
+
+    /**
+     * Returns the original index of each facet, i.e. the facet with index i after
+     * Reorder() had the index GetFacetOrder()[i] before.
+     */
+    const std::vector<FacetIndex>& GetFacetOrder (void) const
+    { return _aulFacetOrder; }
+    /** Returns the original index of each point, like GetFacetOrder(). */
+    const std::vector<PointIndex>& GetPointOrder (void) const
+    { return _aulPointOrder; }
+
+private:
+    void SortByMorton (void);
+    void SortByBreadth (void);
+    void NumberPoints (void);
+
+private:
+    MeshReorder (const MeshReorder&);
+    void operator = (const MeshReorder&);
+
+    MeshKernel& _rclMesh;
+    ThreadPool* _pool;
+    std::vector<FacetIndex> _aulFacetOrder;
+    std::vector<PointIndex> _aulPointOrder;
+};
+
+} // namespace MeshCore
+
+#endif // MESH_REORDER_H
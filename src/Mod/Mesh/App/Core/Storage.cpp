@@ -0,0 +1,117 @@
+/***************************************************************************
+ *   Copyright (c) 2026 The mesh-repair contributors                       *
+ *                                                                         *
+ *   This file is part of mesh-repair, which is based on FreeCAD.          *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# ifdef _WIN32
+#  include <windows.h>
+# else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+# endif
+#endif
+
+#include <Base/Exception.h>
+
+#include "Storage.h"
+
+using namespace MeshCore;
+
+#ifdef _WIN32
+
+MeshMappedFile::MeshMappedFile (const std::string& rclFileName)
+  : _pData(nullptr), _ulSize(0), _hMapping(nullptr)
+{
+    HANDLE hFile = CreateFileA(rclFileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE)
+        throw Base::FileException("Cannot open file", rclFileName.c_str());
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(hFile, &size)) {
+        CloseHandle(hFile);
+        throw Base::FileException("Cannot determine file size", rclFileName.c_str());
+    }
+    _ulSize = static_cast<std::size_t>(size.QuadPart);
+
+    if (_ulSize > 0) {
+        // copy-on-write mapping
+        _hMapping = CreateFileMappingA(hFile, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        if (_hMapping)
+            _pData = static_cast<char*>(MapViewOfFile(_hMapping, FILE_MAP_COPY, 0, 0, 0));
+    }
+    CloseHandle(hFile);
+
+    if (_ulSize > 0 && !_pData) {
+        if (_hMapping)
+            CloseHandle(_hMapping);
+        throw Base::FileException("Cannot map file", rclFileName.c_str());
+    }
+}
+
+MeshMappedFile::~MeshMappedFile ()
+{
+    if (_pData)
+        UnmapViewOfFile(_pData);
+    if (_hMapping)
+        CloseHandle(_hMapping);
+}
+
+#else
+
+MeshMappedFile::MeshMappedFile (const std::string& rclFileName)
+  : _pData(nullptr), _ulSize(0)
+{
+    int fd = open(rclFileName.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw Base::FileException("Cannot open file", rclFileName.c_str());
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw Base::FileException("Cannot determine file size", rclFileName.c_str());
+    }
+    _ulSize = static_cast<std::size_t>(st.st_size);
+
+    if (_ulSize > 0) {
+        // private mapping: modified pages are copied, the file stays untouched
+        void* pData = mmap(nullptr, _ulSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (pData != MAP_FAILED)
+            _pData = static_cast<char*>(pData);
+    }
+    close(fd);
+
+    if (_ulSize > 0 && !_pData)
+        throw Base::FileException("Cannot map file", rclFileName.c_str());
+}
+
+MeshMappedFile::~MeshMappedFile ()
+{
+    if (_pData)
+        munmap(_pData, _ulSize);
+}
+
+#endif
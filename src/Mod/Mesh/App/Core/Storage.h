@@ -0,0 +1,256 @@
+/***************************************************************************
+ *   Copyright (c) 2026 The mesh-repair contributors                       *
+ *                                                                         *
+ *   This file is part of mesh-repair, which is based on FreeCAD.          *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef MESH_STORAGE_H
+#define MESH_STORAGE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "Definitions.h"
+
+namespace MeshCore {
+
+/**
+ * The MeshMappedFile class maps a whole file into memory.
+ * The mapping is private: pages that get modified are copied by the operating
+ * system and the file itself is never changed. Pages that are not modified are
+ * read from the file, thus the file must neither be modified nor truncated while
+ * the mapping exists. A truncated file raises SIGBUS on access.
+ */
+class MeshExport MeshMappedFile
+{
+public:
+    /** Maps the file \a rclFileName. Throws Base::FileException on failure. */
+    explicit MeshMappedFile (const std::string& rclFileName);
+    ~MeshMappedFile ();
+
+    char* Data (void) const
+    { return _pData; }
+    std::size_t Size (void) const
+    { return _ulSize; }
+
+private:
+    MeshMappedFile (const MeshMappedFile&);
+    void operator = (const MeshMappedFile&);
+
+    char* _pData;
+    std::size_t _ulSize;
+#ifdef _WIN32
+    void* _hMapping;
+#endif
+};
+
+/**
+ * A MeshStorageBlock is a piece of memory not owned by the heap, e.g. a part of
+ * a mapped file, that can be adopted once by a container using MeshAllocator.
+ */
+struct MeshStorageBlock
+{
+    MeshStorageBlock (std::shared_ptr<void> owner, char* pData, std::size_t ulSize)
+      : owner(std::move(owner)), data(pData), size(ulSize), taken(false), adopting(false) { }
+
+    bool Contains (const void* p) const
+    { return p >= data && p < data + size; }
+
+    std::shared_ptr<void> owner; /**< Keeps the memory alive, e.g. the MeshMappedFile. */
+    char* data;
+    std::size_t size;
+    bool taken;    /**< The block has been handed out. It is never handed out twice. */
+    bool adopting; /**< While set, default construction in the block keeps its content. */
+};
+
+/**
+ * The MeshAllocator class is the allocator of the point and facet arrays.
+ * Without a storage block it behaves like std::allocator. With a block it hands
+ * out the block for the first allocation that fits, so that a container can use
+ * e.g. a mapped file directly as its element storage without copying it. Copies
+ * of a container always go to the heap.
+ */
+template <class T>
+class MeshAllocator
+{
+public:
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+    typedef std::false_type propagate_on_container_copy_assignment;
+
+    MeshAllocator (void) noexcept { }
+    explicit MeshAllocator (std::shared_ptr<MeshStorageBlock> block) noexcept
+      : _block(std::move(block)) { }
+    template <class U>
+    MeshAllocator (const MeshAllocator<U>& other) noexcept
+      : _block(other.GetBlock()) { }
+
+    T* allocate (std::size_t n)
+    {
+        if (_block && !_block->taken && n * sizeof(T) <= _block->size) {
+            _block->taken = true;
+            return reinterpret_cast<T*>(_block->data);
+        }
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate (T* p, std::size_t n)
+    {
+        if (_block && _block->Contains(p))
+            return; // released together with its owner
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template <class U, class... Args>
+    void construct (U* p, Args&&... args)
+    { ::new(static_cast<void*>(p)) U(std::forward<Args>(args)...); }
+
+    template <class U>
+    void construct (U* p)
+    {
+        // keep the content of the adopted block
+        if (_block && _block->adopting && _block->Contains(p))
+            return;
+        ::new(static_cast<void*>(p)) U();
+    }
+
+    MeshAllocator select_on_container_copy_construction (void) const
+    { return MeshAllocator(); }
+
+    const std::shared_ptr<MeshStorageBlock>& GetBlock (void) const
+    { return _block; }
+
+    template <class U>
+    bool operator == (const MeshAllocator<U>& other) const
+    { return _block == other.GetBlock(); }
+    template <class U>
+    bool operator != (const MeshAllocator<U>& other) const
+    { return _block != other.GetBlock(); }
+
+private:
+    std::shared_ptr<MeshStorageBlock> _block;
+};
+
+/**
+ * The MeshSharedArray class holds a point or facet array that several holders
+ * share until one of them modifies it. Copying a holder only increments a
+ * reference count. The first write access of a holder whose array is shared
+ * copies the whole array, see Detach(). A holder that was never written to
+ * holds no array at all and reads as empty array.
+ *
+ * Holders that share an array can be used by different threads. A single
+ * holder must not be modified while another thread reads it.
+ */
+template <class TArray>
+class MeshSharedArray
+{
+public:
+    MeshSharedArray (void) noexcept : _pBlock(nullptr) { }
+    /** Takes the content of \a rclArray, which is left empty. */
+    explicit MeshSharedArray (TArray& rclArray) : _pBlock(new Block())
+    { _pBlock->array.swap(rclArray); }
+    MeshSharedArray (const MeshSharedArray& rclArray) noexcept : _pBlock(rclArray._pBlock)
+    {
+        if (_pBlock)
+            _pBlock->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    ~MeshSharedArray (void)
+    { Release(); }
+
+    MeshSharedArray& operator = (const MeshSharedArray& rclArray) noexcept
+    {
+        MeshSharedArray clArray(rclArray);
+        Swap(clArray);
+        return *this;
+    }
+    void Swap (MeshSharedArray& rclArray) noexcept
+    { std::swap(_pBlock, rclArray._pBlock); }
+
+    /** Returns the array for reading. */
+    const TArray& Get (void) const
+    {
+        static const TArray clEmpty;
+        return _pBlock ? _pBlock->array : clEmpty;
+    }
+    /** Returns true if another holder shares the array. */
+    bool IsShared (void) const
+    { return _pBlock && _pBlock->refs.load(std::memory_order_acquire) != 1; }
+    /**
+     * Returns the array for writing. A shared array is copied first, so that the
+     * other holders keep their content.
+     */
+    TArray& Detach (void)
+    {
+        if (!_pBlock)
+            _pBlock = new Block();
+        else if (IsShared())
+            Reset(new Block(_pBlock->array));
+        return _pBlock->array;
+    }
+    /**
+     * Hands the array over to \a rclArray, e.g. to reuse its memory, unless it is
+     * shared. In any case the holder is empty afterwards.
+     */
+    void MoveTo (TArray& rclArray) noexcept
+    {
+        if (_pBlock && !IsShared())
+            _pBlock->array.swap(rclArray);
+        Clear();
+    }
+    /** Releases the array, the holder is empty afterwards. */
+    void Clear (void) noexcept
+    {
+        Release();
+        _pBlock = nullptr;
+    }
+
+private:
+    struct Block
+    {
+        Block (void) : refs(1) { }
+        explicit Block (const TArray& rclArray) : refs(1), array(rclArray) { }
+        std::atomic<long> refs;
+        TArray array;
+    };
+
+    void Reset (Block* pBlock) noexcept
+    {
+        Release();
+        _pBlock = pBlock;
+    }
+    void Release (void) noexcept
+    {
+        // the last holder deletes the array after all others have released it
+        if (_pBlock && _pBlock->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete _pBlock;
+    }
+
+    Block* _pBlock;
+};
+
+} // namespace MeshCore
+
+#endif // MESH_STORAGE_H
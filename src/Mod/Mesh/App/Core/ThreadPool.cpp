@@ -0,0 +1,211 @@
+/***************************************************************************
+ *   Copyright (c) 2026 The mesh-repair contributors                       *
+ *                                                                         *
+ *   This file is part of mesh-repair, which is based on FreeCAD.          *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# include <chrono>
+#endif
+
+#include "ThreadPool.h"
+
+using namespace MeshCore;
+
+namespace {
+// the pool and the deque the calling thread works on, if any
+thread_local ThreadPool* t_pool = nullptr;
+thread_local unsigned int t_index = 0;
+}
+
+ThreadPool::ThreadPool (unsigned int ulThreads)
+  : _pending(0), _next(0), _stop(false)
+{
+    if (ulThreads == 0)
+        ulThreads = std::max<unsigned int>(1, std::thread::hardware_concurrency());
+
+    for (unsigned int i = 0; i < ulThreads; i++)
+        _queues.emplace_back(new Queue());
+    for (unsigned int i = 0; i < ulThreads; i++)
+        _workers.emplace_back(&ThreadPool::Work, this, i);
+}
+
+ThreadPool::~ThreadPool ()
+{
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        _stop = true;
+    }
+    _wakeUp.notify_all();
+    for (std::vector<std::thread>::iterator it = _workers.begin(); it != _workers.end(); ++it)
+        it->join();
+}
+
+void ThreadPool::Submit (Task task)
+{
+    unsigned int ulQueue;
+    if (t_pool == this)
+        ulQueue = t_index;
+    else
+        ulQueue = _next.fetch_add(1, std::memory_order_relaxed) % _queues.size();
+
+    // count the task before it becomes visible so that the counter never underflows
+    _pending.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(_queues[ulQueue]->mutex);
+        _queues[ulQueue]->tasks.push_back(std::move(task));
+    }
+
+    // synchronize with a worker that is about to fall asleep
+    { std::lock_guard<std::mutex> lock(_sleepMutex); }
+    _wakeUp.notify_one();
+}
+
+bool ThreadPool::Pop (unsigned int ulQueue, Task& task)
+{
+    Queue& queue = *_queues[ulQueue];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+        return false;
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    _pending.fetch_sub(1);
+    return true;
+}
+
+bool ThreadPool::Steal (unsigned int ulThief, Task& task)
+{
+    std::size_t ulCount = _queues.size();
+    for (std::size_t i = 1; i <= ulCount; i++) {
+        Queue& queue = *_queues[(ulThief + i) % ulCount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            _pending.fetch_sub(1);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool ThreadPool::RunPendingTask (void)
+{
+    Task task;
+    if (t_pool == this) {
+        if (!Pop(t_index, task) && !Steal(t_index, task))
+            return false;
+    }
+    else if (!Steal(0, task)) {
+        return false;
+    }
+
+    task();
+    return true;
+}
+
+void ThreadPool::Work (unsigned int ulIndex)
+{
+    t_pool = this;
+    t_index = ulIndex;
+
+    Task task;
+    for (;;) {
+        if (Pop(ulIndex, task) || Steal(ulIndex, task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_sleepMutex);
+        _wakeUp.wait(lock, [this]() { return _stop || _pending.load() > 0; });
+        if (_stop && _pending.load() == 0)
+            break;
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+TaskGroup::TaskGroup (ThreadPool* pool)
+  : _pool(pool), _active(0)
+{
+}
+
+TaskGroup::~TaskGroup ()
+{
+    try {
+        Wait();
+    }
+    catch (...) {
+        // errors must be handled by an explicit call of Wait()
+    }
+}
+
+void TaskGroup::Run (std::function<void()> task)
+{
+    if (!_pool) {
+        task();
+        return;
+    }
+
+    _active.fetch_add(1);
+    _pool->Submit([this, task]() {
+        try {
+            task();
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_error)
+                _error = std::current_exception();
+        }
+        Finish();
+    });
+}
+
+void TaskGroup::Finish (void)
+{
+    // keep the lock while decrementing so that Wait() cannot return and
+    // destroy the group before the notification is done
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_active.fetch_sub(1) == 1)
+        _done.notify_all();
+}
+
+void TaskGroup::Wait (void)
+{
+    while (_active.load() > 0) {
+        // help instead of blocking a thread that could execute our own tasks
+        if (_pool->RunPendingTask())
+            continue;
+        std::unique_lock<std::mutex> lock(_mutex);
+        _done.wait_for(lock, std::chrono::milliseconds(1), [this]() { return _active.load() == 0; });
+    }
+
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::swap(error, _error);
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
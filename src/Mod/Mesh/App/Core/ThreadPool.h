@@ -0,0 +1,161 @@
+/***************************************************************************
+ *   Copyright (c) 2026 The mesh-repair contributors                       *
+ *                                                                         *
+ *   This file is part of mesh-repair, which is based on FreeCAD.          *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef MESH_THREADPOOL_H
+#define MESH_THREADPOOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Definitions.h"
+
+namespace MeshCore {
+
+/**
+ * The ThreadPool class is a work-stealing pool of worker threads.
+ * Each worker owns a task deque: it takes its own tasks from the back and, when
+ * it runs dry, steals from the front of the other deques. Tasks submitted from
+ * outside the pool are distributed round-robin over the deques.
+ * Threads waiting for a TaskGroup help to execute pending tasks, so nested
+ * parallel sections do not dead-lock and do not oversubscribe the machine.
+ */
+class MeshExport ThreadPool
+{
+public:
+    typedef std::function<void()> Task;
+
+    /// Construction. If \a ulThreads is 0 one worker per hardware thread is started.
+    explicit ThreadPool (unsigned int ulThreads = 0);
+    /// Destruction. Pending tasks are still executed.
+    ~ThreadPool ();
+
+    /** Returns the number of worker threads. */
+    unsigned int CountThreads (void) const
+    { return static_cast<unsigned int>(_workers.size()); }
+    /** Queues the task \a task. */
+    void Submit (Task task);
+    /**
+     * Executes one pending task on the calling thread. Returns false if there
+     * was no task to execute.
+     */
+    bool RunPendingTask (void);
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool Pop (unsigned int ulQueue, Task& task);
+    bool Steal (unsigned int ulThief, Task& task);
+    void Work (unsigned int ulIndex);
+
+private:
+    ThreadPool (const ThreadPool&);
+    void operator = (const ThreadPool&);
+
+    std::vector<std::unique_ptr<Queue> > _queues;
+    std::vector<std::thread> _workers;
+    std::mutex _sleepMutex;
+    std::condition_variable _wakeUp;
+    std::atomic<std::size_t> _pending; /**< Number of queued tasks. */
+    std::atomic<unsigned int> _next;   /**< Round-robin counter for external submissions. */
+    bool _stop;
+};
+
+/**
+ * The TaskGroup class runs a set of tasks on a ThreadPool and waits for their completion.
+ * If no pool is given all tasks are executed immediately on the calling thread.
+ * The first exception thrown by a task is re-thrown by Wait().
+ */
+class MeshExport TaskGroup
+{
+public:
+    explicit TaskGroup (ThreadPool* pool);
+    ~TaskGroup ();
+
+    /** Queues the task \a task. */
+    void Run (std::function<void()> task);
+    /** Waits until all tasks have finished and helps to execute pending tasks meanwhile. */
+    void Wait (void);
+
+private:
+    void Finish (void);
+
+    TaskGroup (const TaskGroup&);
+    void operator = (const TaskGroup&);
+
+    ThreadPool* _pool;
+    std::atomic<std::size_t> _active;
+    std::mutex _mutex;
+    std::condition_variable _done;
+    std::exception_ptr _error;
+};
+
+/**
+ * Returns the chunk size to split \a count elements into for \a pool so that
+ * each worker gets several chunks but no chunk is smaller than \a minimum.
+ */
+inline std::size_t GrainSize (const ThreadPool* pool, std::size_t count, std::size_t minimum)
+{
+    std::size_t threads = pool ? pool->CountThreads() : 1;
+    return std::max<std::size_t>(std::max<std::size_t>(minimum, 1), count / (8 * threads));
+}
+
+/**
+ * Splits the range [\a begin, \a end) into chunks of \a grain elements and calls
+ * \a fn(chunkBegin, chunkEnd) for each chunk on \a pool. If \a pool is null or
+ * there is only one chunk the range is processed on the calling thread.
+ */
+template <class Func>
+void ParallelFor (ThreadPool* pool, std::size_t begin, std::size_t end, std::size_t grain, Func fn)
+{
+    if (begin >= end)
+        return;
+    if (grain == 0)
+        grain = 1;
+    if (!pool || end - begin <= grain) {
+        fn(begin, end);
+        return;
+    }
+
+    TaskGroup group(pool);
+    for (std::size_t b = begin; b < end; b += grain) {
+        std::size_t e = std::min(end, b + grain);
+        group.Run([&fn, b, e]() { fn(b, e); });
+    }
+    group.Wait();
+}
+
+} // namespace MeshCore
+
+#endif // MESH_THREADPOOL_H
@@ -25,6 +25,7 @@
 
 #ifndef _PreComp_
 # include <algorithm>
+# include <cmath>
 # include <utility>
 # include <queue>
 #endif
@@ -37,14 +38,18 @@
 #include "MeshKernel.h"
 #include "Algorithm.h"
 #include "Evaluation.h"
+#include "FlagBitmap.h"
+#include "ThreadPool.h"
+#include "Trace.h"
 #include "Triangulation.h"
+#include "VertexCache.h"
 #include "Definitions.h"
 #include <Base/Console.h>
 
 using namespace MeshCore;
 
 MeshTopoAlgorithm::MeshTopoAlgorithm (MeshKernel &rclM)
-: _rclMesh(rclM), _needsCleanup(false), _cache(0)
+: _rclMesh(rclM), _needsCleanup(false), _pool(nullptr), _trace(nullptr), _workspace(nullptr), _cache(0)
 {
 }
 
@@ -58,23 +63,127 @@ MeshTopoAlgorithm::~MeshTopoAlgorithm (void)
 
 void MeshTopoAlgorithm::Cleanup()
 {
-    _rclMesh.RemoveInvalids();
+    _rclMesh.RemoveInvalids(_pool);
     _needsCleanup = false;
 }
 
+void MeshTopoAlgorithm::BeginCache()
+{
+    if (!_cache)
+        _cache = new MeshVertexCache(MeshDefinitions::_fMinPointDistanceD1);
+    _cache->Clear();
+
+    const MeshPointArray& rPoints = _rclMesh._clPoints.Get();
+    PointIndex nbPoints = static_cast<PointIndex>(rPoints.size());
+    _cache->Reserve(nbPoints);
+    for (PointIndex pntCpt = 0; pntCpt < nbPoints; ++pntCpt)
+        _cache->Add(rPoints[pntCpt], pntCpt);
+}
+
 void MeshTopoAlgorithm::EndCache()
 {
     if (_cache) {
-        _cache->clear();
+        _cache->Clear();
         delete _cache;
         _cache = 0;
     }
 }
 
+PointIndex MeshTopoAlgorithm::GetOrAddIndex (const MeshPoint &rclPoint)
+{
+    MeshPointArray& rPoints = _rclMesh._clPoints.Detach();
+    PointIndex ulSize = static_cast<PointIndex>(rPoints.size());
+    if (_cache) {
+        std::pair<PointIndex, bool> retval = _cache->Insert(rclPoint, ulSize);
+        if (retval.second) {
+            rPoints.push_back(rclPoint);
+            _rclMesh._clBoundBox.Add(rclPoint);
+        }
+        return retval.first;
+    }
 
-void MeshTopoAlgorithm::HarmonizeNormals (void)
+    const float fTol = MeshDefinitions::_fMinPointDistanceD1;
+    for (PointIndex i = 0; i < ulSize; i++) {
+        const MeshPoint& rclP = rPoints[i];
+        if (std::fabs(rclP.x - rclPoint.x) <= fTol &&
+            std::fabs(rclP.y - rclPoint.y) <= fTol &&
+            std::fabs(rclP.z - rclPoint.z) <= fTol)
+            return i;
+    }
+    rPoints.push_back(rclPoint);
+    _rclMesh._clBoundBox.Add(rclPoint);
+    return ulSize;
+}
+
+
+void MeshTopoAlgorithm::HarmonizeNormals (OrientationStrategy tStrategy)
+{
+  MESH_TRACE_SCOPE(_trace, "HarmonizeNormals");
+  std::vector<FacetIndex> aulIndices;
+  std::vector<FacetIndex>& uIndices = _workspace ? _workspace->_aulIndices : aulIndices;
+  bool solved = false;
+  if (tStrategy == ParityUnionFind) {
+    MeshEvalOrientationParity eval(_rclMesh);
+    eval.SetThreadPool(_pool);
+    eval.SetTrace(_trace);
+    solved = eval.GetIndices(uIndices);
+  }
+  if (!solved) {
+    MeshEvalOrientation eval(_rclMesh);
+    eval.SetThreadPool(_pool);
+    eval.SetTrace(_trace);
+    eval.SetWorkspace(_workspace);
+    eval.GetIndices(uIndices);
+  }
+  MESH_TRACE_COUNT(_trace, FlipsApplied, uIndices.size());
+  FlipNormals(uIndices);
+}
+
+void MeshTopoAlgorithm::FlipNormals (std::vector<FacetIndex>& uIndices)
 {
-  std::vector<unsigned long> uIndices = MeshEvalOrientation(_rclMesh).GetIndices();
-  for ( std::vector<unsigned long>::iterator it = uIndices.begin(); it != uIndices.end(); ++it )
-    _rclMesh._aclFacetArray[*it].FlipNormal();
+  MESH_TRACE_SCOPE(_trace, "FlipNormals");
+  if (uIndices.empty())
+    return;
+  // a facet array shared with a copy of the kernel is copied first
+  MeshFacetArray& rFacets = _rclMesh._clFacets.Detach();
+  // the neighbourhood is kept, so is the topology generation
+  _rclMesh._ulGeneration++;
+  const std::size_t ulCount = rFacets.size();
+  MeshFacet* pFacets = rFacets.data();
+
+  if (uIndices.size() < ulCount / 32) {
+    // few facets: flip them in ascending order, the indices are distinct so that
+    // the ranges of the threads are independent
+    if (!std::is_sorted(uIndices.begin(), uIndices.end()))
+      std::sort(uIndices.begin(), uIndices.end());
+    const FacetIndex* pIndices = uIndices.data();
+    ParallelFor(_pool, 0, uIndices.size(), GrainSize(_pool, uIndices.size(), 4096),
+                [pFacets, pIndices](std::size_t b, std::size_t e) {
+      for (std::size_t i = b; i < e; i++)
+        pFacets[pIndices[i]].FlipNormal();
+    });
+    return;
+  }
+
+  // many facets: mark them and stream over the whole array
+  FlagBitmap clFlags;
+  FlagBitmap& rFlags = _workspace ? _workspace->_visited : clFlags;
+  rFlags.Resize(ulCount);
+  const FacetIndex* pIndices = uIndices.data();
+  ParallelFor(_pool, 0, uIndices.size(), GrainSize(_pool, uIndices.size(), 16384),
+              [&rFlags, pIndices](std::size_t b, std::size_t e) {
+    for (std::size_t i = b; i < e; i++)
+      rFlags.SetAtomic(pIndices[i]);
+  });
+  const std::size_t ulWords = rFlags.CountWords();
+  ParallelFor(_pool, 0, ulWords, GrainSize(_pool, ulWords, 256),
+              [&rFlags, pFacets](std::size_t b, std::size_t e) {
+    for (std::size_t w = b; w < e; w++) {
+      FlagBitmap::Word ulBits = rFlags.GetWord(w);
+      for (std::size_t i = w * FlagBitmap::WordBits; ulBits != 0; i++, ulBits >>= 1) {
+        if (ulBits & 1)
+          pFacets[i].FlipNormal();
+      }
+    }
+  });
 }
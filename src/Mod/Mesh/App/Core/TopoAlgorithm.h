@@ -39,6 +39,10 @@
 
 namespace MeshCore {
 
+class MeshOrientationWorkspace;
+class MeshTrace;
+class MeshVertexCache;
+class ThreadPool;
 
 /**
  * The MeshTopoAlgorithm class provides several algorithms to manipulate a mesh.
@@ -60,25 +64,66 @@ public:
      */
     void Cleanup();
    
+    /** Algorithms to find the false oriented facets. */
+    enum OrientationStrategy {
+        RegionGrowing,  /**< Region growing of MeshEvalOrientation. */
+        ParityUnionFind /**< Constraint solving of MeshEvalOrientationParity. */
+    };
+
+    /**
+     * Harmonizes the normals. With \a tStrategy ParityUnionFind the orientation is
+     * solved as constraints in one parallel sweep. If that is not possible for the
+     * mesh the region growing is used.
+     */
+    void HarmonizeNormals (OrientationStrategy tStrategy = RegionGrowing);
     /**
-     * Harmonizes the normals.
+     * Sets the thread pool used by algorithms that support concurrent processing.
+     * By default, i.e. if \a pool is null, everything runs on the calling thread.
      */
-    void HarmonizeNormals (void);
+    void SetThreadPool (ThreadPool* pool)
+    { _pool = pool; }
+    /**
+     * Sets the trace that records the phases and counters of the algorithms if
+     * the library is built with MESH_TRACE.
+     */
+    void SetTrace (MeshTrace* trace)
+    { _trace = trace; }
+    /**
+     * Sets the workspace whose scratch memory HarmonizeNormals() reuses. By default,
+     * i.e. if \a workspace is null, the memory is allocated for each call. The
+     * constraint solving of ParityUnionFind always allocates its own memory.
+     */
+    void SetWorkspace (MeshOrientationWorkspace* workspace)
+    { _workspace = workspace; }
    
     /**
-     * Caching facility.
+     * Caching facility. While the cache is active GetOrAddIndex() finds the
+     * points of the mesh in near-constant time.
      */
     void BeginCache();
+    /** Releases the cache. */
+    void EndCache();
+    /**
+     * Returns the index of the mesh point that coincides with \a rclPoint within
+     * MeshDefinitions::_fMinPointDistanceD1, otherwise appends \a rclPoint to the
+     * point array and returns its new index.
+     */
+    PointIndex GetOrAddIndex (const MeshPoint &rclPoint);
 
 
     
+private:
+    void FlipNormals (std::vector<FacetIndex>& uIndices);
+
 private:
     MeshKernel& _rclMesh;
     bool _needsCleanup;
+    ThreadPool* _pool;
+    MeshTrace* _trace;
+    MeshOrientationWorkspace* _workspace;
 
-   // cache
-    typedef std::map<Base::Vector3f,unsigned long,Vertex_Less> tCache;
-    tCache* _cache;
+    // cache
+    MeshVertexCache* _cache;
 };
 
 
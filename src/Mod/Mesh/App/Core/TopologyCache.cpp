@@ -0,0 +1,249 @@
+/***************************************************************************
+ *   Copyright (c) 2026 The mesh-repair contributors                       *
+ *                                                                         *
+ *   This file is part of mesh-repair, which is based on FreeCAD.          *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# include <atomic>
+# include <memory>
+# include <utility>
+#endif
+
+#include "TopologyCache.h"
+#include "MeshKernel.h"
+#include "ThreadPool.h"
+
+using namespace MeshCore;
+
+namespace {
+// Lock-free union-find where a root is always the smallest index of its set
+FacetIndex FindRoot(std::atomic<FacetIndex>* parents, FacetIndex i)
+{
+    for (;;) {
+        FacetIndex p = parents[i].load(std::memory_order_relaxed);
+        if (p == i)
+            return i;
+        FacetIndex gp = parents[p].load(std::memory_order_relaxed);
+        if (p != gp)
+            parents[i].compare_exchange_weak(p, gp, std::memory_order_relaxed); // path halving
+        i = gp;
+    }
+}
+
+void Unite(std::atomic<FacetIndex>* parents, FacetIndex a, FacetIndex b)
+{
+    for (;;) {
+        a = FindRoot(parents, a);
+        b = FindRoot(parents, b);
+        if (a == b)
+            return;
+        if (a > b)
+            std::swap(a, b);
+        // link the larger root to the smaller one, retry if 'b' got linked meanwhile
+        FacetIndex expected = b;
+        if (parents[b].compare_exchange_strong(expected, a))
+            return;
+    }
+}
+}
+
+MeshTopologyCache::MeshTopologyCache (void)
+  : _bBusy(false), _bTopology(false), _ulTopologyGeneration(0), _bSymmetric(true),
+    _ulBoundaryGeneration(0),
+    _bOrientation(false), _ulOrientationGeneration(0), _ulOrientationComponents(0)
+{
+}
+
+MeshTopologyCache::~MeshTopologyCache (void)
+{
+}
+
+bool MeshTopologyCache::IsCurrent (const MeshKernel& rclMesh) const
+{
+    return _bTopology && _ulTopologyGeneration == rclMesh.GetTopologyGeneration() &&
+           _ulBoundaryGeneration == rclMesh.GetGeneration();
+}
+
+void MeshTopologyCache::Update (const MeshKernel& rclMesh, ThreadPool* pool)
+{
+    // drop outdated entries first, so that they do not add to the memory peak
+    if (_bOrientation && _ulOrientationGeneration != rclMesh.GetGeneration())
+        ClearOrientation();
+
+    // flipped facets keep their components, but not their boundary edges
+    bool bComponents = !_bTopology || _ulTopologyGeneration != rclMesh.GetTopologyGeneration();
+    if (bComponents) {
+        ClearTopology();
+        UpdateComponents(rclMesh, pool);
+    }
+    if (bComponents || _ulBoundaryGeneration != rclMesh.GetGeneration())
+        UpdateBoundary(rclMesh);
+}
+
+void MeshTopologyCache::UpdateComponents (const MeshKernel& rclMesh, ThreadPool* pool)
+{
+    const MeshFacetArray& rFAry = rclMesh.GetFacets();
+    const FacetIndex ulCount = rFAry.size();
+    const std::size_t grain = GrainSize(pool, ulCount, 4096);
+
+    // scratch memory of the labeling, released when done
+    std::unique_ptr<std::atomic<FacetIndex>[]> aRoots(new std::atomic<FacetIndex>[ulCount]);
+    std::atomic<FacetIndex>* parents = aRoots.get();
+    std::atomic<bool> oneSided(false);
+    ParallelFor(pool, 0, ulCount, grain, [&](std::size_t b, std::size_t e) {
+        for (std::size_t i = b; i < e; i++)
+            parents[i].store(i, std::memory_order_relaxed);
+    });
+    ParallelFor(pool, 0, ulCount, grain, [&](std::size_t b, std::size_t e) {
+        for (FacetIndex i = b; i < e; i++) {
+            const MeshFacet& f = rFAry[i];
+            for (int k = 0; k < 3; k++) {
+                FacetIndex j = f._aulNeighbours[k];
+                if (j >= ulCount)
+                    continue; // open edge or error in data structure
+                const MeshFacet& n = rFAry[j];
+                if (n._aulNeighbours[0] != i && n._aulNeighbours[1] != i && n._aulNeighbours[2] != i) {
+                    // one-sided link, 'j' does not unite with 'i' itself
+                    oneSided.store(true, std::memory_order_relaxed);
+                    Unite(parents, i, j);
+                }
+                else if (j > i) {
+                    Unite(parents, i, j);
+                }
+            }
+        }
+    });
+    _bSymmetric = !oneSided;
+
+    // label each facet with its root first, then replace the roots by the number
+    // of their component
+    _aulLabels.resize(ulCount);
+    FacetIndex* labels = _aulLabels.data();
+    ParallelFor(pool, 0, ulCount, grain, [&](std::size_t b, std::size_t e) {
+        for (std::size_t i = b; i < e; i++)
+            labels[i] = FindRoot(parents, i);
+    });
+    FacetIndex ulComponents = 0;
+    for (FacetIndex i = 0; i < ulCount; i++) {
+        if (labels[i] == i)
+            parents[i].store(ulComponents++, std::memory_order_relaxed);
+    }
+    ParallelFor(pool, 0, ulCount, grain, [&](std::size_t b, std::size_t e) {
+        for (std::size_t i = b; i < e; i++)
+            labels[i] = parents[labels[i]].load(std::memory_order_relaxed);
+    });
+
+    // group the facets by component, counting sort keeps them in ascending order,
+    // the union-find memory now holds the next free slot of each component
+    _aulComponentBegin.assign(ulComponents + 1, 0);
+    for (FacetIndex i = 0; i < ulCount; i++)
+        _aulComponentBegin[labels[i] + 1]++;
+    for (FacetIndex c = 0; c < ulComponents; c++) {
+        _aulComponentBegin[c + 1] += _aulComponentBegin[c];
+        parents[c].store(_aulComponentBegin[c], std::memory_order_relaxed);
+    }
+    _aulComponentFacets.resize(ulCount);
+    for (FacetIndex i = 0; i < ulCount; i++) {
+        FacetIndex ulSlot = parents[labels[i]].load(std::memory_order_relaxed);
+        parents[labels[i]].store(ulSlot + 1, std::memory_order_relaxed);
+        _aulComponentFacets[ulSlot] = i;
+    }
+
+    _bTopology = true;
+    _ulTopologyGeneration = rclMesh.GetTopologyGeneration();
+}
+
+void MeshTopologyCache::UpdateBoundary (const MeshKernel& rclMesh)
+{
+    // a flip swaps the sides 0 and 2 of a facet, thus the edges depend on the orientation
+    const MeshFacetArray& rFAry = rclMesh.GetFacets();
+    const FacetIndex ulCount = rFAry.size();
+    _aclBoundary.clear();
+    for (FacetIndex i = 0; i < ulCount; i++) {
+        const MeshFacet& f = rFAry[i];
+        for (unsigned short k = 0; k < 3; k++) {
+            if (f._aulNeighbours[k] == FACET_INDEX_MAX)
+                _aclBoundary.push_back(BoundaryEdge(i, k));
+        }
+    }
+
+    _ulBoundaryGeneration = rclMesh.GetGeneration();
+}
+
+bool MeshTopologyCache::GetOrientation (const MeshKernel& rclMesh, std::vector<FacetIndex>& raulIndices,
+                                        unsigned long& rulComponents) const
+{
+    if (!_bOrientation || _ulOrientationGeneration != rclMesh.GetGeneration())
+        return false;
+    raulIndices.assign(_aulFalseOriented.begin(), _aulFalseOriented.end());
+    rulComponents = _ulOrientationComponents;
+    return true;
+}
+
+void MeshTopologyCache::SetOrientation (const MeshKernel& rclMesh, const std::vector<FacetIndex>& raulIndices,
+                                        unsigned long ulComponents)
+{
+    _aulFalseOriented.assign(raulIndices.begin(), raulIndices.end());
+    _ulOrientationComponents = ulComponents;
+    _ulOrientationGeneration = rclMesh.GetGeneration();
+    _bOrientation = true;
+}
+
+void MeshTopologyCache::Clear (void)
+{
+    ClearTopology();
+    ClearOrientation();
+}
+
+void MeshTopologyCache::ClearTopology (void)
+{
+    _bTopology = false;
+    std::vector<FacetIndex>().swap(_aulLabels);
+    std::vector<FacetIndex>().swap(_aulComponentFacets);
+    std::vector<FacetIndex>().swap(_aulComponentBegin);
+    std::vector<BoundaryEdge>().swap(_aclBoundary);
+    _bSymmetric = true;
+}
+
+void MeshTopologyCache::ClearOrientation (void)
+{
+    _bOrientation = false;
+    std::vector<FacetIndex>().swap(_aulFalseOriented);
+    _ulOrientationComponents = 0;
+}
+
+void MeshTopologyCache::Swap (MeshTopologyCache& rclCache)
+{
+    std::swap(_bTopology, rclCache._bTopology);
+    std::swap(_ulTopologyGeneration, rclCache._ulTopologyGeneration);
+    _aulLabels.swap(rclCache._aulLabels);
+    _aulComponentFacets.swap(rclCache._aulComponentFacets);
+    _aulComponentBegin.swap(rclCache._aulComponentBegin);
+    _aclBoundary.swap(rclCache._aclBoundary);
+    std::swap(_bSymmetric, rclCache._bSymmetric);
+    std::swap(_ulBoundaryGeneration, rclCache._ulBoundaryGeneration);
+    std::swap(_bOrientation, rclCache._bOrientation);
+    std::swap(_ulOrientationGeneration, rclCache._ulOrientationGeneration);
+    _aulFalseOriented.swap(rclCache._aulFalseOriented);
+    std::swap(_ulOrientationComponents, rclCache._ulOrientationComponents);
+}
@@ -0,0 +1,155 @@
+/***************************************************************************
+ *   Copyright (c) 2026 The mesh-repair contributors                       *
+ *                                                                         *
+ *   This file is part of mesh-repair, which is based on FreeCAD.          *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef MESH_TOPOLOGYCACHE_H
+#define MESH_TOPOLOGYCACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "Elements.h"
+
+namespace MeshCore {
+
+class MeshKernel;
+class ThreadPool;
+
+/**
+ * The MeshTopologyCache class keeps the results of topology analyses of a mesh
+ * between calls, so that repeated evaluations of an unmodified mesh skip the
+ * traversal. Each MeshKernel owns one, see MeshKernel::GetTopologyCache().
+ * The components are stamped with the topology generation of the kernel and are
+ * kept if facets are only flipped, see MeshKernel::GetTopologyGeneration(). The
+ * boundary edges and the orientation depend on the orientation of the facets and
+ * are stamped with the generation, see MeshKernel::GetGeneration().
+ * The cache is filled on demand by evaluations of a const kernel. An evaluation
+ * uses it only after Acquire() has succeeded, so that concurrent evaluations of
+ * the same kernel never share it.
+ * The entries take about three indices per facet. Update() drops outdated entries
+ * before it computes new ones, the kernel drops all entries when it is cleared
+ * or assigned.
+ */
+class MeshExport MeshTopologyCache
+{
+public:
+    /** An open edge, i.e. a facet and the side without neighbour. */
+    typedef std::pair<FacetIndex, unsigned short> BoundaryEdge;
+
+    MeshTopologyCache (void);
+    ~MeshTopologyCache (void);
+
+    /**
+     * Computes the components and boundary edges of \a rclMesh unless they are
+     * current. If facets were only flipped just the boundary edges are recomputed.
+     * The labeling runs on \a pool if one is given.
+     */
+    void Update (const MeshKernel& rclMesh, ThreadPool* pool = nullptr);
+    /** Returns true if the components and boundary edges are current for \a rclMesh. */
+    bool IsCurrent (const MeshKernel& rclMesh) const;
+
+    /** Returns the number of connected components. */
+    unsigned long CountComponents (void) const
+    { return _aulComponentBegin.empty() ? 0 : static_cast<unsigned long>(_aulComponentBegin.size() - 1); }
+    /**
+     * Returns the component of each facet. The components are numbered in ascending
+     * order of their smallest facet index.
+     */
+    const std::vector<FacetIndex>& GetLabels (void) const
+    { return _aulLabels; }
+    /**
+     * Returns the facets of all components. The facets of component i are in
+     * ascending order in the range [GetComponentBegin()[i], GetComponentBegin()[i+1]).
+     */
+    const std::vector<FacetIndex>& GetComponentFacets (void) const
+    { return _aulComponentFacets; }
+    const std::vector<FacetIndex>& GetComponentBegin (void) const
+    { return _aulComponentBegin; }
+    /** Returns the smallest facet index of component \a ulComponent. */
+    FacetIndex GetSeed (unsigned long ulComponent) const
+    { return _aulComponentFacets[_aulComponentBegin[ulComponent]]; }
+    /** Returns all edges without neighbour facet in ascending order. */
+    const std::vector<BoundaryEdge>& GetBoundaryEdges (void) const
+    { return _aclBoundary; }
+    /**
+     * Returns false if a facet refers to a neighbour that does not refer back to it.
+     * The components then consist of all facets linked in either direction.
+     */
+    bool IsSymmetric (void) const
+    { return _bSymmetric; }
+
+    /**
+     * Copies the false oriented facets and the number of components found by
+     * MeshEvalOrientation to \a raulIndices and \a rulComponents if they are
+     * current for \a rclMesh, otherwise returns false.
+     */
+    bool GetOrientation (const MeshKernel& rclMesh, std::vector<FacetIndex>& raulIndices,
+                         unsigned long& rulComponents) const;
+    /** Keeps the result of MeshEvalOrientation for the current generation of \a rclMesh. */
+    void SetOrientation (const MeshKernel& rclMesh, const std::vector<FacetIndex>& raulIndices,
+                         unsigned long ulComponents);
+
+    /**
+     * Reserves the cache for the calling evaluation. Returns false without waiting
+     * if another evaluation holds it, the caller then works without the cache.
+     */
+    bool Acquire (void)
+    { return !_bBusy.exchange(true, std::memory_order_acquire); }
+    /** Releases the cache after a successful Acquire(). */
+    void Release (void)
+    { _bBusy.store(false, std::memory_order_release); }
+
+    /** Drops all entries and releases their memory. */
+    void Clear (void);
+    void Swap (MeshTopologyCache& rclCache);
+
+private:
+    MeshTopologyCache (const MeshTopologyCache&);
+    void operator = (const MeshTopologyCache&);
+    void UpdateComponents (const MeshKernel& rclMesh, ThreadPool* pool);
+    void UpdateBoundary (const MeshKernel& rclMesh);
+    void ClearTopology (void);
+    void ClearOrientation (void);
+
+    std::atomic<bool> _bBusy;
+
+    bool _bTopology;
+    uint64_t _ulTopologyGeneration;
+    std::vector<FacetIndex> _aulLabels;
+    std::vector<FacetIndex> _aulComponentFacets;
+    std::vector<FacetIndex> _aulComponentBegin;
+    bool _bSymmetric;
+    uint64_t _ulBoundaryGeneration;
+    std::vector<BoundaryEdge> _aclBoundary;
+
+    bool _bOrientation;
+    uint64_t _ulOrientationGeneration;
+    std::vector<FacetIndex> _aulFalseOriented;
+    unsigned long _ulOrientationComponents;
+};
+
+} // namespace MeshCore
+
+#endif // MESH_TOPOLOGYCACHE_H
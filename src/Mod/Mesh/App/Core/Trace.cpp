@@ -0,0 +1,139 @@
+/***************************************************************************
+ *   Copyright (c) 2026 The mesh-repair contributors                       *
+ *                                                                         *
+ *   This file is part of mesh-repair, which is based on FreeCAD.          *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# include <functional>
+# include <map>
+# include <ostream>
+# include <sstream>
+# include <thread>
+#endif
+
+#include "Trace.h"
+
+using namespace MeshCore;
+
+namespace {
+
+const char* CounterName (int iCounter)
+{
+    switch (iCounter) {
+    case MeshTrace::ComponentsVisited:       return "components";
+    case MeshTrace::FacetsVisited:           return "facets";
+    case MeshTrace::FalsePositiveIterations: return "false_positive_iterations";
+    case MeshTrace::FlipsApplied:            return "flips";
+    default:                                 return "unknown";
+    }
+}
+
+}
+
+MeshTrace::MeshTrace (void)
+  : _clOrigin(Clock::now())
+{
+    for (int i = 0; i < CountCounters; i++)
+        _counters[i].store(0, std::memory_order_relaxed);
+}
+
+MeshTrace::~MeshTrace (void)
+{
+}
+
+void MeshTrace::Record (const char* pName, Clock::time_point clStart, Clock::time_point clEnd)
+{
+    Event event;
+    event.name = pName;
+    event.thread = static_cast<uint64_t>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    event.start = std::chrono::duration_cast<std::chrono::microseconds>(clStart - _clOrigin).count();
+    event.duration = std::chrono::duration_cast<std::chrono::microseconds>(clEnd - clStart).count();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _aclEvents.push_back(event);
+}
+
+void MeshTrace::Clear (void)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _aclEvents.clear();
+    for (int i = 0; i < CountCounters; i++)
+        _counters[i].store(0, std::memory_order_relaxed);
+}
+
+void MeshTrace::WriteChromeTrace (std::ostream& rclOut) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // small thread numbers are easier to read than hashed thread ids
+    std::map<uint64_t, int> threads;
+    for (std::vector<Event>::const_iterator it = _aclEvents.begin(); it != _aclEvents.end(); ++it)
+        threads.insert(std::make_pair(it->thread, static_cast<int>(threads.size())));
+
+    rclOut << "{\"traceEvents\":[";
+    bool bFirst = true;
+    for (std::vector<Event>::const_iterator it = _aclEvents.begin(); it != _aclEvents.end(); ++it) {
+        rclOut << (bFirst ? "\n" : ",\n");
+        rclOut << "{\"name\":\"" << it->name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+               << threads[it->thread] << ",\"ts\":" << it->start << ",\"dur\":" << it->duration << "}";
+        bFirst = false;
+    }
+
+    int64_t end = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - _clOrigin).count();
+    rclOut << (bFirst ? "\n" : ",\n");
+    rclOut << "{\"name\":\"counters\",\"ph\":\"C\",\"pid\":1,\"ts\":" << end << ",\"args\":{";
+    for (int i = 0; i < CountCounters; i++) {
+        rclOut << (i > 0 ? "," : "") << "\"" << CounterName(i) << "\":"
+               << _counters[i].load(std::memory_order_relaxed);
+    }
+    rclOut << "}}\n]}\n";
+}
+
+std::string MeshTrace::Summary (void) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // total time per phase in the order of their first appearance
+    std::vector<std::pair<std::string, int64_t> > phases;
+    for (std::vector<Event>::const_iterator it = _aclEvents.begin(); it != _aclEvents.end(); ++it) {
+        std::vector<std::pair<std::string, int64_t> >::iterator jt = phases.begin();
+        while (jt != phases.end() && jt->first != it->name)
+            ++jt;
+        if (jt == phases.end())
+            phases.push_back(std::make_pair(std::string(it->name), it->duration));
+        else
+            jt->second += it->duration;
+    }
+
+    std::ostringstream str;
+    str.setf(std::ios::fixed);
+    str.precision(3);
+    for (std::vector<std::pair<std::string, int64_t> >::const_iterator it = phases.begin(); it != phases.end(); ++it)
+        str << it->first << "=" << it->second / 1000.0 << "ms ";
+    for (int i = 0; i < CountCounters; i++) {
+        str << (i > 0 ? " " : "") << CounterName(i) << "="
+            << _counters[i].load(std::memory_order_relaxed);
+    }
+    return str.str();
+}
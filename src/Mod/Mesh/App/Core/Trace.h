@@ -0,0 +1,143 @@
+/***************************************************************************
+ *   Copyright (c) 2026 The mesh-repair contributors                       *
+ *                                                                         *
+ *   This file is part of mesh-repair, which is based on FreeCAD.          *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef MESH_TRACE_H
+#define MESH_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Definitions.h"
+
+namespace MeshCore {
+
+/**
+ * The MeshTrace class records the phases and counters of an algorithm, e.g. of the
+ * normal harmonization. Phases are recorded as begin/duration events per thread,
+ * counters are summed up. Both can be recorded from several threads at once.
+ *
+ * The algorithms only record if the library is built with MESH_TRACE, otherwise the
+ * MESH_TRACE_SCOPE and MESH_TRACE_COUNT macros expand to nothing and a trace that is
+ * set stays empty.
+ */
+class MeshExport MeshTrace
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    enum Counter {
+        ComponentsVisited,       /**< Topologic independent components harmonized. */
+        FacetsVisited,           /**< Facets reached by the region growing. */
+        FalsePositiveIterations, /**< Iterations of the false positive correction. */
+        FlipsApplied,            /**< Facets whose normal got flipped. */
+        CountCounters
+    };
+
+    MeshTrace (void);
+    ~MeshTrace (void);
+
+    /** Adds \a ulValue to the counter \a tCounter. */
+    void Add (Counter tCounter, unsigned long ulValue)
+    { _counters[tCounter].fetch_add(ulValue, std::memory_order_relaxed); }
+    /** Returns the value of the counter \a tCounter. */
+    unsigned long Get (Counter tCounter) const
+    { return _counters[tCounter].load(std::memory_order_relaxed); }
+    /** Records the phase \a pName that ran from \a clStart to \a clEnd on the calling thread. */
+    void Record (const char* pName, Clock::time_point clStart, Clock::time_point clEnd);
+    /** Removes all events and resets the counters. */
+    void Clear (void);
+
+    /** Writes the events and counters in the Chrome trace event format (chrome://tracing). */
+    void WriteChromeTrace (std::ostream& rclOut) const;
+    /** Returns one line with the total time of each phase and the counters. */
+    std::string Summary (void) const;
+
+private:
+    struct Event {
+        const char* name; /**< Must be a literal. */
+        uint64_t thread;
+        int64_t start;    /**< In microseconds since the creation of the trace. */
+        int64_t duration; /**< In microseconds. */
+    };
+
+    MeshTrace (const MeshTrace&);
+    void operator = (const MeshTrace&);
+
+    Clock::time_point _clOrigin;
+    std::atomic<unsigned long> _counters[CountCounters];
+    mutable std::mutex _mutex;
+    std::vector<Event> _aclEvents;
+};
+
+/**
+ * The MeshTraceScope class records the lifetime of an instance as phase of a trace.
+ * Nothing is recorded if the trace is null.
+ */
+class MeshTraceScope
+{
+public:
+    MeshTraceScope (MeshTrace* pTrace, const char* pName)
+      : _pTrace(pTrace), _pName(pName)
+    {
+        if (_pTrace)
+            _clStart = MeshTrace::Clock::now();
+    }
+    ~MeshTraceScope (void)
+    {
+        if (_pTrace)
+            _pTrace->Record(_pName, _clStart, MeshTrace::Clock::now());
+    }
+
+private:
+    MeshTraceScope (const MeshTraceScope&);
+    void operator = (const MeshTraceScope&);
+
+    MeshTrace* _pTrace;
+    const char* _pName;
+    MeshTrace::Clock::time_point _clStart;
+};
+
+} // namespace MeshCore
+
+#define MESH_TRACE_CONCAT2(a, b) a##b
+#define MESH_TRACE_CONCAT(a, b) MESH_TRACE_CONCAT2(a, b)
+
+#ifdef MESH_TRACE
+/// Records the rest of the enclosing block as phase \a name of \a trace.
+# define MESH_TRACE_SCOPE(trace, name) \
+    MeshCore::MeshTraceScope MESH_TRACE_CONCAT(meshTraceScope, __LINE__)(trace, name)
+/// Adds \a value to the counter \a counter of \a trace.
+# define MESH_TRACE_COUNT(trace, counter, value) \
+    do { if (trace) (trace)->Add(MeshCore::MeshTrace::counter, static_cast<unsigned long>(value)); } while (0)
+#else
+# define MESH_TRACE_SCOPE(trace, name) ((void)0)
+# define MESH_TRACE_COUNT(trace, counter, value) ((void)0)
+#endif
+
+#endif // MESH_TRACE_H
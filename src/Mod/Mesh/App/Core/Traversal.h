@@ -0,0 +1,403 @@
+/***************************************************************************
+ *   Copyright (c) 2026 The mesh-repair contributors                       *
+ *                                                                         *
+ *   This file is part of mesh-repair, which is based on FreeCAD.          *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef MESH_TRAVERSAL_H
+#define MESH_TRAVERSAL_H
+
+#include <atomic>
+#include <bitset>
+#include <vector>
+
+#include "Elements.h"
+#include "FlagBitmap.h"
+#include "ThreadPool.h"
+
+namespace MeshCore {
+
+/**
+ * The MeshFacetTraversal class does the breadth-first traversal of
+ * MeshKernel::VisitNeighbourFacets as a template on the visitor type, so that
+ * the visitor gets inlined into the loop if its type is known. The visitor does
+ * not need to derive from MeshFacetVisitor, it only needs a matching Visit() method.
+ * Visited facets are kept in a FlagBitmap. The frontier buffers are kept between
+ * the calls, thus a traversal used for many start facets does not allocate again.
+ * An instance must not be used by several threads at the same time.
+ */
+class MeshFacetTraversal
+{
+public:
+    explicit MeshFacetTraversal (const MeshFacetArray& rclFacets)
+      : _rclFacets(rclFacets)
+    {
+    }
+
+    /**
+     * Visits all unvisited facets reachable from \a ulStartFacet ring by ring and calls
+     * \a rclVisitor.Visit(facet, from, index, level) for each of them but the start facet.
+     * If Visit() returns false the traversal stops immediately. Returns the number of
+     * visited facets. Behaves exactly like MeshKernel::VisitNeighbourFacets().
+     */
+    template <class TVisitor>
+    unsigned long VisitNeighbours (TVisitor& rclVisitor, FacetIndex ulStartFacet, FlagBitmap& rclVisited)
+    {
+        return Traverse(ulStartFacet, rclVisited, [&rclVisitor](const MeshFacet& rclFacet,
+            const MeshFacet& rclFrom, FacetIndex ulFInd, unsigned long ulLevel) {
+            return rclVisitor.Visit(rclFacet, rclFrom, ulFInd, ulLevel);
+        }, [](const std::vector<FacetIndex>&, unsigned long) {
+            return true;
+        });
+    }
+
+    /**
+     * Visits the same facets as VisitNeighbours() but calls \a rclVisitor.VisitRing(ring, level)
+     * once for each complete ring of newly visited facets. If VisitRing() returns false
+     * the traversal stops after this ring. Returns the number of visited facets.
+     */
+    template <class TVisitor>
+    unsigned long VisitRings (TVisitor& rclVisitor, FacetIndex ulStartFacet, FlagBitmap& rclVisited)
+    {
+        return Traverse(ulStartFacet, rclVisited, [](const MeshFacet&, const MeshFacet&,
+            FacetIndex, unsigned long) {
+            return true;
+        }, [&rclVisitor](const std::vector<FacetIndex>& rclRing, unsigned long ulLevel) {
+            return rclVisitor.VisitRing(rclRing, ulLevel);
+        });
+    }
+
+    /**
+     * Exchanges the ring buffers with \a rclCurrent and \a rclNext, e.g. to use
+     * buffers that are kept between the traversals of several meshes.
+     */
+    void SwapBuffers (std::vector<FacetIndex>& rclCurrent, std::vector<FacetIndex>& rclNext)
+    {
+        _aulCurrent.swap(rclCurrent);
+        _aulNext.swap(rclNext);
+    }
+
+private:
+    template <class TFacetFunc, class TRingFunc>
+    unsigned long Traverse (FacetIndex ulStartFacet, FlagBitmap& rclVisited,
+                            TFacetFunc visitFacet, TRingFunc visitRing)
+    {
+        unsigned long ulVisited = 0, ulLevel = 0;
+        const FacetIndex ulCount = _rclFacets.size();
+        const MeshFacet* pFacets = _rclFacets.data();
+
+        // pick up start point
+        _aulCurrent.clear();
+        _aulNext.clear();
+        _aulCurrent.push_back(ulStartFacet);
+        rclVisited.Set(ulStartFacet);
+
+        // as long as free neighbours
+        while (!_aulCurrent.empty()) {
+            for (std::size_t k = 0; k < _aulCurrent.size(); k++) {
+                const MeshFacet& rclCurr = pFacets[_aulCurrent[k]];
+
+                for (int i = 0; i < 3; i++) {
+                    FacetIndex j = rclCurr._aulNeighbours[i];
+                    if (j >= ulCount)
+                        continue;      // no neighbour facet or error in data structure
+                    if (rclVisited.Test(j))
+                        continue;      // neighbour facet already visited
+
+                    // visit and mark
+                    ulVisited++;
+                    _aulNext.push_back(j);
+                    rclVisited.Set(j);
+                    if (!visitFacet(pFacets[j], rclCurr, j, ulLevel))
+                        return ulVisited;
+                }
+            }
+
+            if (!_aulNext.empty() && !visitRing(_aulNext, ulLevel))
+                return ulVisited;
+
+            _aulCurrent.clear();
+            _aulCurrent.swap(_aulNext);
+            ulLevel++;
+        }
+
+        return ulVisited;
+    }
+
+private:
+    const MeshFacetArray& _rclFacets;
+    std::vector<FacetIndex> _aulCurrent; /**< Current ring, reused between the calls. */
+    std::vector<FacetIndex> _aulNext;    /**< Next ring, reused between the calls. */
+};
+
+/**
+ * The MeshParallelFacetTraversal class does the same traversal as MeshFacetTraversal
+ * but expands large rings on a ThreadPool, e.g. for a single component with millions
+ * of facets. Each facet of the next ring is claimed by the first facet of the current
+ * ring that reaches it, so the rings, their order and the facets they are reached from
+ * are exactly those of the serial traversal, independent of the number of threads.
+ *
+ * The claims are kept in an array \a pClaims with one entry per facet that must be
+ * initialized with FACET_INDEX_MAX and is restored after each ring. As components are
+ * disjoint, several traversals of different components may share the array and the
+ * visited bitmap at the same time.
+ *
+ * Optionally a ring is expanded bottom-up: instead of the neighbours of the ring all
+ * unvisited facets look for a neighbour in the ring, which is cheaper when the ring
+ * is a large part of the rest. This requires that a facet is the neighbour of its
+ * neighbours and that no other traversal uses the claims or the bitmap meanwhile.
+ */
+class MeshParallelFacetTraversal
+{
+public:
+    MeshParallelFacetTraversal (const MeshFacetArray& rclFacets, ThreadPool* pool,
+                                std::atomic<FacetIndex>* pClaims)
+      : _rclFacets(rclFacets), _pool(pool), _pClaims(pClaims), _bBottomUp(false),
+        _ulMinParallel(4096), _ulUnvisited(0)
+    {
+    }
+
+    /** Enables bottom-up expansion of large rings, see above for the requirements. */
+    void SetBottomUp (bool on)
+    { _bBottomUp = on; }
+
+    /**
+     * Visits all unvisited facets reachable from \a ulStartFacet and calls
+     * \a rclVisitor.VisitRing(ring, from, level) for each complete ring, where from[k]
+     * is the facet ring[k] is reached from. If VisitRing() returns false the traversal
+     * stops after this ring. Returns the number of visited facets.
+     */
+    template <class TVisitor>
+    unsigned long VisitRings (TVisitor& rclVisitor, FacetIndex ulStartFacet, FlagBitmap& rclVisited)
+    {
+        unsigned long ulVisited = 0, ulLevel = 0;
+        _aulRing.clear();
+        _aulRing.push_back(ulStartFacet);
+        rclVisited.SetAtomic(ulStartFacet);
+        _ulUnvisited = 0; // counted on demand
+
+        while (!_aulRing.empty()) {
+            _aulNext.clear();
+            _aulNextFrom.clear();
+            if (!_pool || !_pClaims || _aulRing.size() < _ulMinParallel)
+                ExpandSerial(rclVisited);
+            else
+                ExpandParallel(rclVisited);
+
+            if (_aulNext.empty())
+                break;
+            ulVisited += _aulNext.size();
+            if (_ulUnvisited > 0)
+                _ulUnvisited -= std::min(_ulUnvisited, _aulNext.size());
+            if (!rclVisitor.VisitRing(_aulNext, _aulNextFrom, ulLevel))
+                break;
+
+            _aulRing.swap(_aulNext);
+            ulLevel++;
+        }
+
+        return ulVisited;
+    }
+
+private:
+    void ExpandSerial (FlagBitmap& rclVisited)
+    {
+        const FacetIndex ulCount = _rclFacets.size();
+        for (std::vector<FacetIndex>::const_iterator it = _aulRing.begin(); it != _aulRing.end(); ++it) {
+            const MeshFacet& rclCurr = _rclFacets[*it];
+            for (int i = 0; i < 3; i++) {
+                FacetIndex j = rclCurr._aulNeighbours[i];
+                if (j >= ulCount || rclVisited.Test(j))
+                    continue;
+                rclVisited.SetAtomic(j);
+                _aulNext.push_back(j);
+                _aulNextFrom.push_back(*it);
+            }
+        }
+    }
+
+    void ExpandParallel (FlagBitmap& rclVisited)
+    {
+        const FacetIndex ulCount = _rclFacets.size();
+        const MeshFacet* pFacets = _rclFacets.data();
+        std::atomic<FacetIndex>* pClaims = _pClaims;
+        const std::vector<FacetIndex>& ring = _aulRing;
+        const std::size_t ulGrain = GrainSize(_pool, ring.size(), 1024);
+
+        if (UseBottomUp(rclVisited))
+            ClaimBottomUp(rclVisited);
+        else {
+            // each unvisited neighbour keeps the smallest ring position that reaches it
+            ParallelFor(_pool, 0, ring.size(), ulGrain, [&](std::size_t b, std::size_t e) {
+                for (std::size_t k = b; k < e; k++) {
+                    const MeshFacet& rclCurr = pFacets[ring[k]];
+                    for (int i = 0; i < 3; i++) {
+                        FacetIndex j = rclCurr._aulNeighbours[i];
+                        if (j >= ulCount || rclVisited.Test(j))
+                            continue;
+                        FacetIndex ulClaim = pClaims[j].load(std::memory_order_relaxed);
+                        while (k < ulClaim && !pClaims[j].compare_exchange_weak(ulClaim, static_cast<FacetIndex>(k),
+                                                                                std::memory_order_relaxed))
+                            ;
+                    }
+                }
+            });
+        }
+
+        // collect the claimed facets chunk by chunk in the order of the serial traversal
+        const std::size_t ulChunks = (ring.size() + ulGrain - 1) / ulGrain;
+        _aclChunks.resize(ulChunks);
+        ParallelFor(_pool, 0, ulChunks, 1, [&](std::size_t b, std::size_t e) {
+            for (std::size_t c = b; c < e; c++) {
+                std::vector<FacetIndex>& chunk = _aclChunks[c];
+                chunk.clear();
+                std::size_t ulEnd = std::min(ring.size(), (c + 1) * ulGrain);
+                for (std::size_t k = c * ulGrain; k < ulEnd; k++) {
+                    const MeshFacet& rclCurr = pFacets[ring[k]];
+                    for (int i = 0; i < 3; i++) {
+                        FacetIndex j = rclCurr._aulNeighbours[i];
+                        if (j >= ulCount || rclVisited.Test(j))
+                            continue;
+                        if (pClaims[j].load(std::memory_order_relaxed) != k)
+                            continue;
+                        // a degenerated facet may reach the same neighbour twice
+                        if ((i > 0 && rclCurr._aulNeighbours[0] == j) || (i > 1 && rclCurr._aulNeighbours[1] == j))
+                            continue;
+                        chunk.push_back(j);
+                        chunk.push_back(ring[k]);
+                    }
+                }
+            }
+        });
+
+        std::vector<std::size_t> aulOffsets(ulChunks + 1, 0);
+        for (std::size_t c = 0; c < ulChunks; c++)
+            aulOffsets[c + 1] = aulOffsets[c] + _aclChunks[c].size() / 2;
+        _aulNext.resize(aulOffsets[ulChunks]);
+        _aulNextFrom.resize(aulOffsets[ulChunks]);
+        ParallelFor(_pool, 0, ulChunks, 1, [&](std::size_t b, std::size_t e) {
+            for (std::size_t c = b; c < e; c++) {
+                const std::vector<FacetIndex>& chunk = _aclChunks[c];
+                for (std::size_t k = 0; k < chunk.size() / 2; k++) {
+                    _aulNext[aulOffsets[c] + k] = chunk[2 * k];
+                    _aulNextFrom[aulOffsets[c] + k] = chunk[2 * k + 1];
+                }
+            }
+        });
+
+        // mark the new ring and release the claims
+        ParallelFor(_pool, 0, _aulNext.size(), GrainSize(_pool, _aulNext.size(), 1024),
+                    [&](std::size_t b, std::size_t e) {
+            for (std::size_t k = b; k < e; k++) {
+                rclVisited.SetAtomic(_aulNext[k]);
+                pClaims[_aulNext[k]].store(FACET_INDEX_MAX, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    bool UseBottomUp (const FlagBitmap& rclVisited)
+    {
+        if (!_bBottomUp)
+            return false;
+        if (_ulUnvisited == 0) {
+            std::atomic<std::size_t> ulSet(0);
+            ParallelFor(_pool, 0, rclVisited.CountWords(), GrainSize(_pool, rclVisited.CountWords(), 4096),
+                        [&](std::size_t b, std::size_t e) {
+                std::size_t ulCount = 0;
+                for (std::size_t w = b; w < e; w++)
+                    ulCount += std::bitset<FlagBitmap::WordBits>(rclVisited.GetWord(w)).count();
+                ulSet += ulCount;
+            });
+            _ulUnvisited = rclVisited.Size() - ulSet;
+        }
+        // the ring has more edges than a fraction of the unvisited facets
+        return _aulRing.size() * 14 > _ulUnvisited;
+    }
+
+    void ClaimBottomUp (const FlagBitmap& rclVisited)
+    {
+        const FacetIndex ulCount = _rclFacets.size();
+        const MeshFacet* pFacets = _rclFacets.data();
+        std::atomic<FacetIndex>* pClaims = _pClaims;
+        const std::vector<FacetIndex>& ring = _aulRing;
+
+        // the ring facets hold their position
+        ParallelFor(_pool, 0, ring.size(), GrainSize(_pool, ring.size(), 1024), [&](std::size_t b, std::size_t e) {
+            for (std::size_t k = b; k < e; k++)
+                pClaims[ring[k]].store(static_cast<FacetIndex>(k), std::memory_order_relaxed);
+        });
+
+        const std::size_t ulWords = rclVisited.CountWords();
+        ParallelFor(_pool, 0, ulWords, GrainSize(_pool, ulWords, 256), [&](std::size_t b, std::size_t e) {
+            for (std::size_t w = b; w < e; w++) {
+                FlagBitmap::Word ulFree = ~rclVisited.GetWord(w);
+                while (ulFree != 0) {
+                    std::size_t bit = 0;
+                    while (((ulFree >> bit) & 1) == 0)
+                        bit++;
+                    ulFree &= ulFree - 1;
+                    FacetIndex j = static_cast<FacetIndex>(w * FlagBitmap::WordBits + bit);
+                    if (j >= ulCount)
+                        break;
+
+                    // the smallest position of a ring facet that has j as neighbour
+                    FacetIndex ulClaim = FACET_INDEX_MAX;
+                    const MeshFacet& rclFacet = pFacets[j];
+                    for (int i = 0; i < 3; i++) {
+                        FacetIndex q = rclFacet._aulNeighbours[i];
+                        if (q >= ulCount || !rclVisited.Test(q))
+                            continue;
+                        FacetIndex ulPos = pClaims[q].load(std::memory_order_relaxed);
+                        if (ulPos < ulClaim) {
+                            const MeshFacet& rclRing = pFacets[q];
+                            if (rclRing._aulNeighbours[0] == j || rclRing._aulNeighbours[1] == j ||
+                                rclRing._aulNeighbours[2] == j)
+                                ulClaim = ulPos;
+                        }
+                    }
+                    if (ulClaim != FACET_INDEX_MAX)
+                        pClaims[j].store(ulClaim, std::memory_order_relaxed);
+                }
+            }
+        });
+
+        ParallelFor(_pool, 0, ring.size(), GrainSize(_pool, ring.size(), 1024), [&](std::size_t b, std::size_t e) {
+            for (std::size_t k = b; k < e; k++)
+                pClaims[ring[k]].store(FACET_INDEX_MAX, std::memory_order_relaxed);
+        });
+    }
+
+private:
+    const MeshFacetArray& _rclFacets;
+    ThreadPool* _pool;
+    std::atomic<FacetIndex>* _pClaims;
+    bool _bBottomUp;
+    std::size_t _ulMinParallel;      /**< Smaller rings are expanded serially. */
+    std::size_t _ulUnvisited;        /**< Estimated number of unvisited facets, 0 if unknown. */
+    std::vector<FacetIndex> _aulRing;
+    std::vector<FacetIndex> _aulNext;
+    std::vector<FacetIndex> _aulNextFrom;
+    std::vector<std::vector<FacetIndex> > _aclChunks;
+};
+
+} // namespace MeshCore
+
+#endif // MESH_TRAVERSAL_H
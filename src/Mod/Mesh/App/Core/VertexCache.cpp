@@ -0,0 +1,167 @@
+/***************************************************************************
+ *   Copyright (c) 2026 The mesh-repair contributors                       *
+ *                                                                         *
+ *   This file is part of mesh-repair, which is based on FreeCAD.          *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# include <algorithm>
+# include <cmath>
+#endif
+
+#include "VertexCache.h"
+
+using namespace MeshCore;
+
+namespace {
+
+/** Checks whether no coordinate of \a rclP and \a rclQ differs by more than \a fTol. */
+inline bool IsWithin (const Base::Vector3f& rclP, const Base::Vector3f& rclQ, double fTol)
+{
+    return std::fabs(double(rclP.x) - double(rclQ.x)) <= fTol &&
+           std::fabs(double(rclP.y) - double(rclQ.y)) <= fTol &&
+           std::fabs(double(rclP.z) - double(rclQ.z)) <= fTol;
+}
+
+}
+
+MeshVertexCache::MeshVertexCache (float fTolerance)
+  : _fTolerance(std::max<float>(fTolerance, 0.0f)), _ulMask(0), _ulSize(0)
+{
+    // an exact cache only needs to keep equal points in one cell
+    _fInvCellSize = _fTolerance > 0.0f ? 0.5 / double(_fTolerance) : 1.0;
+}
+
+MeshVertexCache::~MeshVertexCache (void)
+{
+}
+
+void MeshVertexCache::Reserve (std::size_t ulCount)
+{
+    // keep the table at most half full so that the probe sequences stay short
+    std::size_t ulCapacity = 16;
+    while (ulCapacity < 2 * ulCount)
+        ulCapacity *= 2;
+    if (ulCapacity > _aclSlots.size())
+        Rehash(ulCapacity);
+}
+
+void MeshVertexCache::Clear (void)
+{
+    Slot clEmpty;
+    clEmpty.index = POINT_INDEX_MAX;
+    std::fill(_aclSlots.begin(), _aclSlots.end(), clEmpty);
+    _ulSize = 0;
+}
+
+int64_t MeshVertexCache::Cell (double fCoord) const
+{
+    // NaN and infinite or huge coordinates end up in a fixed cell, the limit is
+    // exact as double and leaves room for the loops over neighbouring cells
+    const double fLimit = 4611686018427387904.0; // 2^62
+    double fCell = std::floor(fCoord * _fInvCellSize);
+    if (std::isnan(fCell))
+        return 0;
+    return static_cast<int64_t>(std::max(-fLimit, std::min(fCell, fLimit)));
+}
+
+std::size_t MeshVertexCache::Hash (int64_t x, int64_t y, int64_t z) const
+{
+    uint64_t ulHash = static_cast<uint64_t>(x) * 73856093ULL ^
+                      static_cast<uint64_t>(y) * 19349663ULL ^
+                      static_cast<uint64_t>(z) * 83492791ULL;
+    // neighbouring cells must not end up in neighbouring slots
+    ulHash *= 0x9E3779B97F4A7C15ULL;
+    return static_cast<std::size_t>(ulHash >> 32) & _ulMask;
+}
+
+PointIndex MeshVertexCache::Find (const Base::Vector3f& rclPoint) const
+{
+    if (_ulSize == 0)
+        return POINT_INDEX_MAX;
+
+    // all cells overlapped by the tolerance box around the point
+    const double fTol = _fTolerance;
+    const int64_t lX0 = Cell(double(rclPoint.x) - fTol);
+    const int64_t lX1 = Cell(double(rclPoint.x) + fTol);
+    const int64_t lY0 = Cell(double(rclPoint.y) - fTol);
+    const int64_t lY1 = Cell(double(rclPoint.y) + fTol);
+    const int64_t lZ0 = Cell(double(rclPoint.z) - fTol);
+    const int64_t lZ1 = Cell(double(rclPoint.z) + fTol);
+
+    PointIndex ulBest = POINT_INDEX_MAX;
+    for (int64_t x = lX0; x <= lX1; x++) {
+        for (int64_t y = lY0; y <= lY1; y++) {
+            for (int64_t z = lZ0; z <= lZ1; z++) {
+                // the points of a cell lie between its home slot and the next empty slot
+                for (std::size_t i = Hash(x, y, z); _aclSlots[i].index != POINT_INDEX_MAX; i = (i + 1) & _ulMask) {
+                    const Slot& rclSlot = _aclSlots[i];
+                    if (rclSlot.index < ulBest && IsWithin(rclSlot.point, rclPoint, fTol))
+                        ulBest = rclSlot.index;
+                }
+            }
+        }
+    }
+
+    return ulBest;
+}
+
+std::pair<PointIndex, bool> MeshVertexCache::Insert (const Base::Vector3f& rclPoint, PointIndex ulIndex)
+{
+    PointIndex ulFound = Find(rclPoint);
+    if (ulFound != POINT_INDEX_MAX)
+        return std::make_pair(ulFound, false);
+    Add(rclPoint, ulIndex);
+    return std::make_pair(ulIndex, true);
+}
+
+void MeshVertexCache::Add (const Base::Vector3f& rclPoint, PointIndex ulIndex)
+{
+    if (2 * (_ulSize + 1) > _aclSlots.size())
+        Rehash(std::max<std::size_t>(16, 2 * _aclSlots.size()));
+    Store(rclPoint, ulIndex);
+    _ulSize++;
+}
+
+void MeshVertexCache::Store (const Base::Vector3f& rclPoint, PointIndex ulIndex)
+{
+    std::size_t i = Hash(Cell(rclPoint.x), Cell(rclPoint.y), Cell(rclPoint.z));
+    while (_aclSlots[i].index != POINT_INDEX_MAX)
+        i = (i + 1) & _ulMask;
+    _aclSlots[i].point = rclPoint;
+    _aclSlots[i].index = ulIndex;
+}
+
+void MeshVertexCache::Rehash (std::size_t ulCapacity)
+{
+    Slot clEmpty;
+    clEmpty.index = POINT_INDEX_MAX;
+    std::vector<Slot> aclOld(ulCapacity, clEmpty);
+    aclOld.swap(_aclSlots);
+    _ulMask = ulCapacity - 1;
+
+    for (std::vector<Slot>::const_iterator it = aclOld.begin(); it != aclOld.end(); ++it) {
+        if (it->index != POINT_INDEX_MAX)
+            Store(it->point, it->index);
+    }
+}
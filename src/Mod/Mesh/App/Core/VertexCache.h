@@ -0,0 +1,111 @@
+/***************************************************************************
+ *   Copyright (c) 2026 The mesh-repair contributors                       *
+ *                                                                         *
+ *   This file is part of mesh-repair, which is based on FreeCAD.          *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef MESH_VERTEXCACHE_H
+#define MESH_VERTEXCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "Elements.h"
+
+#include <Base/Vector3D.h>
+
+namespace MeshCore {
+
+/**
+ * The MeshVertexCache class maps points to their index in the point array while
+ * treating points as equal if none of their coordinates differs by more than the
+ * tolerance.
+ * The points are bucketed in a grid whose cells have twice the tolerance as edge
+ * length, so that the tolerance box of a query overlaps at most eight cells. The
+ * cells are stored in one open-addressing table with linear probing: a lookup
+ * walks a few contiguous slots instead of a chain of tree nodes, and inserting
+ * only allocates when the table grows.
+ * If several cached points lie within the tolerance of a query the one with the
+ * lowest index is returned, independent of the insertion order.
+ */
+class MeshExport MeshVertexCache
+{
+public:
+    /// Construction. A tolerance of 0 only matches identical points.
+    explicit MeshVertexCache (float fTolerance);
+    ~MeshVertexCache (void);
+
+    /// Reserves space for \a ulCount points without rehashing.
+    void Reserve (std::size_t ulCount);
+    /// Removes all points but keeps the memory.
+    void Clear (void);
+    /// Returns the number of cached points.
+    std::size_t Size (void) const
+    { return _ulSize; }
+    float GetTolerance (void) const
+    { return _fTolerance; }
+
+    /**
+     * Returns the lowest index of the cached points within the tolerance of
+     * \a rclPoint, or POINT_INDEX_MAX if there is none.
+     */
+    PointIndex Find (const Base::Vector3f& rclPoint) const;
+    /**
+     * Looks up \a rclPoint and adds it with \a ulIndex if no cached point lies
+     * within the tolerance. Returns the index of the cached point and true if
+     * \a rclPoint has been added.
+     */
+    std::pair<PointIndex, bool> Insert (const Base::Vector3f& rclPoint, PointIndex ulIndex);
+    /**
+     * Adds \a rclPoint with \a ulIndex without looking it up first. This is used
+     * to fill the cache with the points of a mesh that may already contain
+     * duplicates; Find() still returns the lowest index of them.
+     */
+    void Add (const Base::Vector3f& rclPoint, PointIndex ulIndex);
+
+private:
+    struct Slot
+    {
+        Base::Vector3f point;
+        PointIndex index; /**< POINT_INDEX_MAX marks an empty slot. */
+    };
+
+    int64_t Cell (double fCoord) const;
+    std::size_t Hash (int64_t x, int64_t y, int64_t z) const;
+    void Store (const Base::Vector3f& rclPoint, PointIndex ulIndex);
+    void Rehash (std::size_t ulCapacity);
+
+private:
+    MeshVertexCache (const MeshVertexCache&);
+    void operator = (const MeshVertexCache&);
+
+    float _fTolerance;
+    double _fInvCellSize;
+    std::vector<Slot> _aclSlots;
+    std::size_t _ulMask;
+    std::size_t _ulSize;
+};
+
+} // namespace MeshCore
+
+#endif // MESH_VERTEXCACHE_H
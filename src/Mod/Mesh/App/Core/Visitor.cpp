@@ -23,10 +23,76 @@
 
 #include "PreCompiled.h"
 
+#ifndef _PreComp_
+# include <vector>
+#endif
+
 #include "MeshKernel.h"
 #include "Visitor.h"
 #include "Algorithm.h"
 #include "Approximation.h"
+#include "FlagBitmap.h"
+#include "Traversal.h"
 
 using namespace MeshCore;
 
+unsigned long MeshKernel::VisitNeighbourFacets (MeshFacetVisitor &rclFVisitor, FacetIndex ulStartFacet) const
+{
+    unsigned long ulVisited = 0, ulLevel = 0;
+    FacetIndex j;
+    // the VISIT flags are written, thus a shared facet array is copied first
+    MeshFacetArray& rFacets = _clFacets.Detach();
+    FacetIndex ulCount = rFacets.size();
+    std::vector<FacetIndex> clCurrentLevel, clNextLevel;
+    std::vector<FacetIndex>::iterator  clCurrIter;
+    MeshFacetArray::_TConstIterator clCurrFacet, clNBFacet;
+
+    // pick up start point
+    clCurrentLevel.push_back(ulStartFacet);
+    rFacets[ulStartFacet].SetFlag(MeshFacet::VISIT);
+
+    // as long as free neighbours
+    while (clCurrentLevel.size() > 0) {
+        // visit all neighbours of the current level
+        for (clCurrIter = clCurrentLevel.begin(); clCurrIter < clCurrentLevel.end(); ++clCurrIter) {
+            clCurrFacet = rFacets.begin() + *clCurrIter;
+
+            // visit all neighbours of the current level if not yet done
+            for (unsigned short i = 0; i < 3; i++) {
+                j = clCurrFacet->_aulNeighbours[i]; // index to neighbour facet
+                if (j == FACET_INDEX_MAX)
+                    continue;      // no neighbour facet
+
+                if (j >= ulCount)
+                    continue;      // error in data structure
+
+                clNBFacet = rFacets.begin() + j;
+
+                if (clNBFacet->IsFlag(MeshFacet::VISIT) == true)
+                    continue;      // neighbour facet already visited
+                else {
+                    // visit and mark
+                    ulVisited++;
+                    clNextLevel.push_back(j);
+                    clNBFacet->SetFlag(MeshFacet::VISIT);
+                    if (rclFVisitor.Visit(*clNBFacet, *clCurrFacet, j, ulLevel) == false)
+                        return ulVisited;
+                }
+            }
+        }
+
+        clCurrentLevel.clear();
+        clCurrentLevel.swap(clNextLevel);
+        ulLevel++;
+    }
+
+    return ulVisited;
+}
+
+unsigned long MeshKernel::VisitNeighbourFacets (MeshFacetVisitor &rclFVisitor, FacetIndex ulStartFacet,
+                                                FlagBitmap& rclVisited) const
+{
+    MeshFacetTraversal traversal(_clFacets.Get());
+    return traversal.VisitNeighbours(rclFVisitor, ulStartFacet, rclVisited);
+}
+
@@ -24,6 +24,8 @@
 #ifndef VISITOR_H
 #define VISITOR_H
 
+#include "Elements.h"
+
 namespace MeshCore {
 
 class MeshFacetVisitor;
@@ -47,7 +49,8 @@ public:
      * If \a true is returned the next iteration is done if there are still facets to visit.
      * If \a false is returned the calling method stops immediately visiting further facets.
      */
-  
+    virtual bool Visit (const MeshFacet &rclFacet, const MeshFacet &rclFrom, 
+                        FacetIndex ulFInd, unsigned long ulLevel) = 0;
 };
 
 
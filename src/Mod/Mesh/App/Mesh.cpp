@@ -25,6 +25,7 @@
 #ifndef _PreComp_
 # include <algorithm>
 # include <sstream>
+# include <utility>
 #endif
 
 #include <CXX/Objects.hxx>
@@ -78,6 +79,16 @@ MeshObject::MeshObject(const MeshCore::MeshKernel& Kernel, const Base::Matrix4D
     // copy the mesh structure
 }
 
+MeshObject::MeshObject(MeshCore::MeshKernel&& Kernel)
+  : _kernel(std::move(Kernel))
+{
+}
+
+MeshObject::MeshObject(MeshCore::MeshKernel&& Kernel, const Base::Matrix4D &Mtrx)
+  : _Mtrx(Mtrx),_kernel(std::move(Kernel))
+{
+}
+
 MeshObject::MeshObject(const MeshObject& mesh)
   : _Mtrx(mesh._Mtrx),_kernel(mesh._kernel)
 {
@@ -85,12 +96,40 @@ MeshObject::MeshObject(const MeshObject& mesh)
     copySegments(mesh);
 }
 
+MeshObject::MeshObject(MeshObject&& mesh) noexcept
+  : _Mtrx(mesh._Mtrx),_kernel(std::move(mesh._kernel))
+{
+    // takes the segments without copying, they are re-bound to this object
+    swapSegments(mesh);
+}
+
+MeshObject& MeshObject::operator=(MeshObject&& mesh) noexcept
+{
+    if (this != &mesh) {
+        _Mtrx = mesh._Mtrx;
+        _kernel = std::move(mesh._kernel);
+        swapSegments(mesh);
+        // the segments swapped over refer to the released mesh
+        mesh.clearSegments();
+    }
+    return *this;
+}
+
 MeshObject::~MeshObject()
 {
 }
 
-void MeshObject::harmonizeNormals()
+void MeshObject::swapKernel(MeshCore::MeshKernel& kernel)
+{
+    _kernel.Swap(kernel);
+}
+
+void MeshObject::harmonizeNormals(MeshCore::ThreadPool* pool, MeshCore::MeshTrace* trace,
+                                  MeshCore::MeshOrientationWorkspace* workspace)
 {
     MeshCore::MeshTopoAlgorithm alg(_kernel);
+    alg.SetThreadPool(pool);
+    alg.SetTrace(trace);
+    alg.SetWorkspace(workspace);
     alg.HarmonizeNormals();
 }
@@ -56,6 +56,9 @@ namespace Base {
 
 namespace MeshCore {
 class AbstractPolygonTriangulator;
+class MeshOrientationWorkspace;
+class MeshTrace;
+class ThreadPool;
 }
 
 namespace Mesh
@@ -76,11 +79,32 @@ public:
     MeshObject();
     explicit MeshObject(const MeshCore::MeshKernel& Kernel);
     explicit MeshObject(const MeshCore::MeshKernel& Kernel, const Base::Matrix4D &Mtrx);
+    /// Takes the points and facets of \a Kernel without copying them
+    explicit MeshObject(MeshCore::MeshKernel&& Kernel);
+    explicit MeshObject(MeshCore::MeshKernel&& Kernel, const Base::Matrix4D &Mtrx);
     MeshObject(const MeshObject&);
+    /// Takes the mesh of \a mesh without copying it
+    MeshObject(MeshObject&&) noexcept;
+    /// Takes the mesh of \a mesh without copying it, \a mesh is left empty
+    MeshObject& operator=(MeshObject&&) noexcept;
     virtual ~MeshObject();
 
-   
-    void harmonizeNormals();
+
+    /** Returns the underlying mesh kernel. */
+    const MeshCore::MeshKernel& getKernel() const
+    { return _kernel; }
+    /**
+     * Exchanges the mesh kernel with \a kernel without copying the points and facets,
+     * so that a caller can reuse its arrays for several meshes.
+     */
+    void swapKernel(MeshCore::MeshKernel& kernel);
+
+    /**
+     * Harmonizes the normals, using \a pool, recording in \a trace and reusing the
+     * scratch memory of \a workspace if given.
+     */
+    void harmonizeNormals(MeshCore::ThreadPool* pool = nullptr, MeshCore::MeshTrace* trace = nullptr,
+                          MeshCore::MeshOrientationWorkspace* workspace = nullptr);
 
 private:
     MeshCore::MeshKernel _kernel;
@@ -0,0 +1,242 @@
+/***************************************************************************
+ *   Copyright (c) 2026 The mesh-repair contributors                       *
+ *                                                                         *
+ *   This file is part of mesh-repair, which is based on FreeCAD.          *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "PreCompiled.h"
+#ifndef _PreComp_
+# include <algorithm>
+# include <exception>
+# include <limits>
+# include <memory>
+# include <new>
+# include <string>
+# include <vector>
+#endif
+
+#include "Core/Elements.h"
+#include "Core/Evaluation.h"
+#include "Core/MeshKernel.h"
+#include "Core/ThreadPool.h"
+
+#include "MeshRepair.h"
+
+using namespace MeshCore;
+
+struct mesh_repair_context
+{
+    mesh_repair_context() : plan(kernel), nonManifolds(0)
+    {
+        plan.SetWorkspace(&workspace);
+    }
+
+    std::unique_ptr<ThreadPool> pool;
+    MeshKernel kernel;
+    MeshPointArray points;  /**< Stays empty, the orientation needs no geometry. */
+    MeshFacetArray facets;  /**< Facets of the previous call, reused as buffer. */
+    MeshOrientationWorkspace workspace; /**< Scratch memory and flip set of the plan. */
+    MeshOrientationPlan plan;
+    unsigned long nonManifolds;
+    std::string error;
+};
+
+namespace {
+
+/**
+ * Largest number of facets or points the interface accepts. Every index must
+ * stay below the invalid marker of the kernel and fit into the uint32_t
+ * indices handed back to the caller.
+ */
+const size_t MaxElements = static_cast<size_t>(
+    std::min<uint64_t>(ELEMENT_INDEX_MAX, std::numeric_limits<uint32_t>::max()));
+
+int Fail (mesh_repair_context* context, int status, const char* message)
+{
+    context->error = message;
+    return status;
+}
+
+/**
+ * Builds the facets with their neighbourhood from the corner indices and plans
+ * the orientation. The caller's array is only read.
+ */
+int Evaluate (mesh_repair_context* context, const uint32_t* indices,
+              size_t count_facets, size_t count_points)
+{
+    if (count_facets > 0 && !indices)
+        return Fail(context, MESH_REPAIR_INVALID_ARGUMENT, "no index array");
+    if (count_facets > MaxElements || count_points > MaxElements)
+        return Fail(context, MESH_REPAIR_INVALID_ARGUMENT, "too many facets or points");
+    for (size_t i = 0; i < 3 * count_facets; i++) {
+        if (indices[i] >= count_points)
+            return Fail(context, MESH_REPAIR_INDEX_OUT_OF_RANGE, "point index out of range");
+    }
+
+    MeshFacetArray& facets = context->facets;
+    facets.resize(count_facets);
+    for (size_t i = 0; i < count_facets; i++) {
+        MeshFacet& facet = facets[i];
+        facet._aulPoints[0] = indices[3 * i];
+        facet._aulPoints[1] = indices[3 * i + 1];
+        facet._aulPoints[2] = indices[3 * i + 2];
+        facet._ucFlag = 0;
+    }
+
+    // the kernel hands back the facets of the previous call as buffer for the next one
+    context->points.clear();
+    context->kernel.Adopt(context->points, facets);
+    context->nonManifolds = context->kernel.RebuildNeighbours(context->pool.get());
+
+    context->plan.SetThreadPool(context->pool.get());
+    context->plan.Compute();
+    return MESH_REPAIR_OK;
+}
+
+template <class Func>
+int Guard (mesh_repair_context* context, Func fn)
+{
+    if (!context)
+        return MESH_REPAIR_INVALID_ARGUMENT;
+    try {
+        context->error.clear();
+        return fn();
+    }
+    catch (const std::bad_alloc&) {
+        return Fail(context, MESH_REPAIR_OUT_OF_MEMORY, "out of memory");
+    }
+    catch (const std::exception& e) {
+        return Fail(context, MESH_REPAIR_FAILED, e.what());
+    }
+    catch (...) {
+        return Fail(context, MESH_REPAIR_FAILED, "unknown error");
+    }
+}
+
+}
+
+extern "C" {
+
+mesh_repair_context* mesh_repair_create(unsigned int threads)
+{
+    try {
+        std::unique_ptr<mesh_repair_context> context(new mesh_repair_context());
+        if (threads != 1)
+            context->pool.reset(new ThreadPool(threads));
+        return context.release();
+    }
+    catch (...) {
+        return nullptr;
+    }
+}
+
+void mesh_repair_destroy(mesh_repair_context* context)
+{
+    delete context;
+}
+
+int mesh_repair_harmonize(mesh_repair_context* context,
+                          uint32_t* indices, size_t count_facets, size_t count_points,
+                          size_t* count_flipped, size_t* count_non_manifolds)
+{
+    return Guard(context, [&]() {
+        int status = Evaluate(context, indices, count_facets, count_points);
+        if (status != MESH_REPAIR_OK)
+            return status;
+
+        // same as MeshFacet::FlipNormal
+        const std::vector<FacetIndex>& set = context->plan.GetIndices();
+        for (std::vector<FacetIndex>::const_iterator it = set.begin(); it != set.end(); ++it)
+            std::swap(indices[3 * *it + 1], indices[3 * *it + 2]);
+
+        if (count_flipped)
+            *count_flipped = set.size();
+        if (count_non_manifolds)
+            *count_non_manifolds = context->nonManifolds;
+        return static_cast<int>(MESH_REPAIR_OK);
+    });
+}
+
+int mesh_repair_flip_set(mesh_repair_context* context,
+                         const uint32_t* indices, size_t count_facets, size_t count_points,
+                         uint32_t* flipped, size_t capacity, size_t* count_flipped)
+{
+    return Guard(context, [&]() {
+        if (capacity > 0 && !flipped)
+            return Fail(context, MESH_REPAIR_INVALID_ARGUMENT, "no flip set buffer");
+        int status = Evaluate(context, indices, count_facets, count_points);
+        if (status != MESH_REPAIR_OK)
+            return status;
+
+        const std::vector<FacetIndex>& set = context->plan.GetIndices();
+        std::size_t count = std::min(capacity, set.size());
+        for (std::size_t i = 0; i < count; i++)
+            flipped[i] = static_cast<uint32_t>(set[i]);
+
+        if (count_flipped)
+            *count_flipped = set.size();
+        if (set.size() > capacity)
+            return Fail(context, MESH_REPAIR_BUFFER_TOO_SMALL, "flip set buffer too small");
+        return static_cast<int>(MESH_REPAIR_OK);
+    });
+}
+
+int mesh_repair_plan(mesh_repair_context* context,
+                     const uint32_t* indices, size_t count_facets, size_t count_points,
+                     int format, void* buffer, size_t capacity,
+                     mesh_repair_plan_summary* summary)
+{
+    return Guard(context, [&]() {
+        if (format != MESH_REPAIR_PLAN_BITMAP && format != MESH_REPAIR_PLAN_RANGES)
+            return Fail(context, MESH_REPAIR_INVALID_ARGUMENT, "unknown plan format");
+        if (capacity > 0 && !buffer)
+            return Fail(context, MESH_REPAIR_INVALID_ARGUMENT, "no plan buffer");
+        int status = Evaluate(context, indices, count_facets, count_points);
+        if (status != MESH_REPAIR_OK)
+            return status;
+
+        const MeshOrientationPlan& plan = context->plan;
+        std::size_t size;
+        if (format == MESH_REPAIR_PLAN_BITMAP)
+            size = sizeof(uint64_t) * plan.WriteBitmap(static_cast<uint64_t*>(buffer), capacity / sizeof(uint64_t));
+        else
+            size = 2 * sizeof(uint32_t) * plan.WriteRanges(static_cast<uint32_t*>(buffer), capacity / (2 * sizeof(uint32_t)));
+
+        if (summary) {
+            const MeshOrientationPlan::Summary& info = plan.GetSummary();
+            summary->count_facets = info.countFacets;
+            summary->count_components = info.countComponents;
+            summary->count_flipped = info.countFlipped;
+            summary->count_ranges = info.countRanges;
+            summary->count_non_manifolds = context->nonManifolds;
+            summary->size = size;
+        }
+        if (size > capacity)
+            return Fail(context, MESH_REPAIR_BUFFER_TOO_SMALL, "plan buffer too small");
+        return static_cast<int>(MESH_REPAIR_OK);
+    });
+}
+
+const char* mesh_repair_last_error(const mesh_repair_context* context)
+{
+    return context ? context->error.c_str() : "no context";
+}
+
+}
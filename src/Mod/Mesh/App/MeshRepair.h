@@ -0,0 +1,120 @@
+/***************************************************************************
+ *   Copyright (c) 2026 The mesh-repair contributors                       *
+ *                                                                         *
+ *   This file is part of mesh-repair, which is based on FreeCAD.          *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef MESH_REPAIR_H
+#define MESH_REPAIR_H
+
+/*
+ * C interface to the normal harmonization, e.g. for cgo.
+ *
+ * A mesh is passed as caller-owned array of 3 * count_facets corner point
+ * indices. The array is never kept after a call returns, so memory owned by
+ * a garbage collector can be passed directly. The orientation only depends on
+ * the topology, hence no coordinates are needed.
+ *
+ * A context owns a thread pool and the buffers reused by all calls. A context
+ * must not be used by several threads at the same time, different contexts can.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+# define MESH_REPAIR_API __declspec(dllexport)
+#else
+# define MESH_REPAIR_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct mesh_repair_context mesh_repair_context;
+
+enum mesh_repair_status {
+    MESH_REPAIR_OK = 0,
+    MESH_REPAIR_INVALID_ARGUMENT = 1,   /* null pointer, empty context or more than
+                                           UINT32_MAX facets or points */
+    MESH_REPAIR_INDEX_OUT_OF_RANGE = 2, /* a corner index is not below count_points */
+    MESH_REPAIR_BUFFER_TOO_SMALL = 3,   /* the flip set does not fit into the buffer */
+    MESH_REPAIR_OUT_OF_MEMORY = 4,
+    MESH_REPAIR_FAILED = 5
+};
+
+/* Creates a context with threads worker threads, 0 for one per core, 1 for none. */
+MESH_REPAIR_API mesh_repair_context* mesh_repair_create(unsigned int threads);
+MESH_REPAIR_API void mesh_repair_destroy(mesh_repair_context* context);
+
+/*
+ * Harmonizes the normals by reordering the corners of the false oriented
+ * facets in place. Optionally returns the number of flipped facets and the
+ * number of edges shared by more than two facets.
+ */
+MESH_REPAIR_API int mesh_repair_harmonize(mesh_repair_context* context,
+                                          uint32_t* indices, size_t count_facets, size_t count_points,
+                                          size_t* count_flipped, size_t* count_non_manifolds);
+
+/*
+ * Writes the ascending indices of the false oriented facets to flipped without
+ * modifying the mesh. count_flipped receives the size of the flip set, if it
+ * exceeds capacity MESH_REPAIR_BUFFER_TOO_SMALL is returned and the first
+ * capacity indices are written.
+ */
+MESH_REPAIR_API int mesh_repair_flip_set(mesh_repair_context* context,
+                                         const uint32_t* indices, size_t count_facets, size_t count_points,
+                                         uint32_t* flipped, size_t capacity, size_t* count_flipped);
+
+/* Encodings of the flip set written by mesh_repair_plan. */
+enum mesh_repair_plan_format {
+    MESH_REPAIR_PLAN_BITMAP = 0, /* uint64_t words, bit i % 64 of word i / 64 set if facet i flips */
+    MESH_REPAIR_PLAN_RANGES = 1  /* uint32_t pairs, the first facet of a range and one past its last */
+};
+
+typedef struct mesh_repair_plan_summary {
+    uint64_t count_facets;
+    uint64_t count_components;    /* topologic independent components */
+    uint64_t count_flipped;       /* false oriented facets */
+    uint64_t count_ranges;        /* ranges of consecutive false oriented facets */
+    uint64_t count_non_manifolds; /* edges shared by more than two facets */
+    uint64_t size;                /* bytes of the encoded flip set */
+} mesh_repair_plan_summary;
+
+/*
+ * Encodes the flip set of the mesh in format into buffer without modifying the
+ * mesh and fills summary. buffer must be aligned to 8 bytes. If the encoding
+ * exceeds capacity bytes MESH_REPAIR_BUFFER_TOO_SMALL is returned, only a prefix
+ * is written and summary->size tells the capacity needed.
+ */
+MESH_REPAIR_API int mesh_repair_plan(mesh_repair_context* context,
+                                     const uint32_t* indices, size_t count_facets, size_t count_points,
+                                     int format, void* buffer, size_t capacity,
+                                     mesh_repair_plan_summary* summary);
+
+/* Returns the message of the last failed call of the context. */
+MESH_REPAIR_API const char* mesh_repair_last_error(const mesh_repair_context* context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MESH_REPAIR_H */